@@ -1,35 +1,251 @@
 
 #include "raylib.h"
 #include "raymath.h"
+#include <transform/FixedTimestep.h>
 #include <transform/GameTransform.h>
+#include <transform/KinematicBodies.h>
+#include <render/DebugDraw.h>
+#include <render/HudText.h>
+#include <render/InstanceBatch.h>
+#include <render/RenderQueue.h>
+#include <render/RenderModel.h>
+#include <render/RenderStats.h>
+#include <render/TransformCamera.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
+#include <memory>
+#include <numeric>
+#include <vector>
 
 using namespace GameEngine;
 
-// Draw a model with extended parameters
-void DrawModelPro(Model model, Matrix transform, Color tint)
+// Command line options.
+typedef struct ExampleOptions
 {
-    // Combine model transformation matrix (model.transform) with matrix generated by function parameters (matTransform)
-    model.transform = MatrixMultiply(model.transform, transform);
+    bool headless;      // Run the update loop only, without a window
+    int frames;         // Frames simulated in headless mode
+    int crateCount;     // Crates in the scene
+    const char* csvFile; // Per frame render counters, written by headless runs
+} ExampleOptions;
 
-    for (int i = 0; i < model.meshCount; i++)
+// Stand-in for a material in headless runs, where nothing can be loaded on the GPU.
+typedef struct HeadlessMaterial
+{
+    int locs[32];
+    MaterialMap maps[MAX_MATERIAL_MAPS];
+    Material material;
+} HeadlessMaterial;
+
+// World space values read back every frame.
+typedef struct SceneReadout
+{
+    RotationAxisAngle cubeRotation;
+    Vector3 cubePosition;
+    Vector3 cubeScale;
+    RotationAxisAngle sphereRotation;
+    Vector3 spherePosition;
+    Vector3 sphereScale;
+} SceneReadout;
+
+// Transforms of the example, shared by the windowed and headless runs.
+class ExampleScene
+{
+public:
+    GameTransform worldTransform;
+    GameTransform cubeTransform;
+    GameTransform sphereTransform;
+    std::vector<std::unique_ptr<GameTransform>> crateTransforms;
+    // Crates spin on their own, integrated together instead of set one by one.
+    KinematicBodies crateMotion;
+
+    ExampleScene(int crateCount) :
+        worldTransform(
+            { 0.0, 0.0, 0.0 }, // Position
+            {{ 0.0, 1.0, 0.0 }, 0.0}, // Rotation
+            { 1.0, 1.0, 1.0 }  // Scale
+        ),
+        cubeTransform(
+            { 1.0, 1.0, 1.0 }, // Position
+            {{ 1.0, 1.0, 1.0 }, 0.0 }, // Rotation
+            { 2.0, 2.0, 2.0 }  // Scale
+        ),
+        sphereTransform(
+            { 0.0, 1.0, 1.0 },
+            {{ 1.0, 1.0, 1.0 }, 0.0},
+            { 0.5, 0.5, 0.5 }
+        )
     {
-        Color color = model.materials[model.meshMaterial[i]].maps[MATERIAL_MAP_DIFFUSE].color;
+        cubeTransform.SetParent(&worldTransform);
+        sphereTransform.SetParent(&cubeTransform);
 
-        Color colorTint = WHITE;
-        colorTint.r = (unsigned char)((((float)color.r/255.0)*((float)tint.r/255.0))*255.0f);
-        colorTint.g = (unsigned char)((((float)color.g/255.0)*((float)tint.g/255.0))*255.0f);
-        colorTint.b = (unsigned char)((((float)color.b/255.0)*((float)tint.b/255.0))*255.0f);
-        colorTint.a = (unsigned char)((((float)color.a/255.0)*((float)tint.a/255.0))*255.0f);
+        // Crates, laid out on a grid around the world origin.
+        int crateRows = (int)ceilf(sqrtf((float)crateCount));
+        for (int i = 0; i < crateCount; i++)
+        {
+            float crateX = (float)(i%crateRows) - crateRows/2.0f + 0.5f;
+            float crateZ = (float)(i/crateRows) - crateRows/2.0f + 0.5f;
+            crateTransforms.emplace_back(new GameTransform(
+                { crateX*4.0f, -0.5f, crateZ*4.0f },
+                {{ 0.0, 1.0, 0.0 }, 0.0 },
+                { 0.5, 0.5, 0.5 }
+            ));
+            crateTransforms.back()->SetParent(&worldTransform);
+            // Sixty degrees per second, backwards.
+            int body = crateMotion.Add(crateTransforms.back().get());
+            crateMotion.SetAngularVelocity(body, { 0.0f, -PI/3.0f, 0.0f });
+        }
+    }
 
-        model.materials[model.meshMaterial[i]].maps[MATERIAL_MAP_DIFFUSE].color = colorTint;
-        DrawMesh(model.meshes[i], model.materials[model.meshMaterial[i]], model.transform);
-        model.materials[model.meshMaterial[i]].maps[MATERIAL_MAP_DIFFUSE].color = color;
+    // Set this frame's rotations, move the crates on by deltaTime and read back world
+    // space values.
+    SceneReadout Update(float spin, float deltaTime)
+    {
+        worldTransform.SetLocalRotation({ {0.0, 1.0, 0.0}, spin * 0.5f });
+        cubeTransform.SetLocalRotation({ {1.0, 0.0, 1.0}, spin });
+        sphereTransform.SetLocalRotation({ {1.0, 1.0, 0.0}, spin });
+        crateMotion.Integrate(deltaTime);
+
+        SceneReadout readout = { 0 };
+        readout.cubeRotation = cubeTransform.GetWorldRotation();
+        readout.cubePosition = cubeTransform.GetWorldPosition();
+        readout.cubeScale = cubeTransform.GetWorldScale();
+        readout.sphereRotation = sphereTransform.GetWorldRotation();
+        readout.spherePosition = sphereTransform.GetWorldPosition();
+        readout.sphereScale = sphereTransform.GetWorldScale();
+        return readout;
     }
+};
+
+void InitHeadlessMaterial(HeadlessMaterial* headless, unsigned int shaderId, bool instanced)
+{
+    for (int& loc: headless->locs) loc = -1;
+    if (instanced) headless->locs[SHADER_LOC_MATRIX_MODEL] = 0;
+    for (MaterialMap& map: headless->maps) map = { { 0 }, WHITE, 0.0f };
+    headless->material = { { shaderId, headless->locs }, headless->maps, { 0.0f } };
+    // No GL context to look the attribute up, so the instancing shader opts in.
+    InstanceBatcher::SetSupportsInstancing(headless->material.shader, instanced);
+}
+
+bool ParseOptions(int argc, char* argv[], ExampleOptions* options)
+{
+    options->headless = false;
+    options->frames = 1000;
+    options->crateCount = 64;
+    options->csvFile = nullptr;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--headless") == 0) options->headless = true;
+        else if ((strcmp(argv[i], "--frames") == 0) && (i + 1 < argc)) options->frames = atoi(argv[++i]);
+        else if ((strcmp(argv[i], "--objects") == 0) && (i + 1 < argc)) options->crateCount = atoi(argv[++i]);
+        else if ((strcmp(argv[i], "--csv") == 0) && (i + 1 < argc)) options->csvFile = argv[++i];
+        else
+        {
+            std::cerr << "Usage: " << argv[0] << " [--headless] [--frames N] [--objects N] [--csv FILE]" << std::endl;
+            return false;
+        }
+    }
+    return (options->frames > 0) && (options->crateCount >= 0);
+}
+
+// Run the update loop without a window and report frame timings.
+int RunHeadless(const ExampleOptions& options)
+{
+    ExampleScene scene(options.crateCount);
+    std::vector<double> frameTimes(options.frames, 0.0);
+    float spin = 0.0f;
+    // Keeps the optimizer from dropping the world queries.
+    float checksum = 0.0f;
+
+    // Draws are submitted as in the windowed run, but only counted.
+    SetRenderStatsDryRun(true);
+    RenderStatsLog statsLog;
+    Mesh cubeMesh = { 0 };
+    cubeMesh.vertexCount = 24;
+    cubeMesh.triangleCount = 12;
+    Mesh sphereMesh = { 0 };
+    sphereMesh.vertexCount = 600;
+    sphereMesh.triangleCount = 200;
+    HeadlessMaterial modelMaterial;
+    InitHeadlessMaterial(&modelMaterial, 1, false);
+    HeadlessMaterial crateMaterial;
+    InitHeadlessMaterial(&crateMaterial, 2, true);
+    // Instance matrices go through a ring in plain memory, there is no GPU to upload to.
+    CpuInstanceRingBackend instanceRingBackend;
+    InstanceRing instanceRing(&instanceRingBackend, (int)scene.crateTransforms.size() + 16);
+    RenderQueue renderQueue;
+    renderQueue.SetDepthRange(0.0f, 100.0f);
+    renderQueue.SetInstanceRing(&instanceRing);
+    InstanceBatcher crateBatcher;
+    crateBatcher.SetInstanceRing(&instanceRing);
+
+    for (int frame = 0; frame < options.frames; frame++)
+    {
+        auto frameStart = std::chrono::steady_clock::now();
+
+        BeginRenderStats();
+        // One degree of spin per frame is sixty per second at 60 FPS.
+        SceneReadout readout = scene.Update(spin, 1.0f/60.0f);
+        instanceRing.BeginFrame();
+        renderQueue.Begin();
+        renderQueue.Push(0, cubeMesh, modelMaterial.material, scene.cubeTransform.GetLocalToWorldMatrix(), 10.0f);
+        renderQueue.Push(0, sphereMesh, modelMaterial.material, scene.sphereTransform.GetLocalToWorldMatrix(), 10.0f);
+        renderQueue.Sort();
+        renderQueue.Submit();
+        crateBatcher.Begin();
+        for (const std::unique_ptr<GameTransform>& crate: scene.crateTransforms)
+        {
+            crateBatcher.Add(cubeMesh, crateMaterial.material, *crate);
+        }
+        crateBatcher.Draw();
+        instanceRing.EndFrame();
+        checksum += readout.spherePosition.x;
+        spin += 1.0f;
+
+        auto frameEnd = std::chrono::steady_clock::now();
+        frameTimes[frame] = std::chrono::duration<double, std::micro>(frameEnd - frameStart).count();
+        statsLog.Record(GetRenderStatsInProgress(), frameTimes[frame]);
+    }
+    SetRenderStatsDryRun(false);
+
+    std::vector<double> sorted = frameTimes;
+    std::sort(sorted.begin(), sorted.end());
+    double total = std::accumulate(sorted.begin(), sorted.end(), 0.0);
+    auto percentile = [&sorted](double fraction) {
+        return sorted[(size_t)(fraction*(sorted.size() - 1))];
+    };
+
+    std::cout << "frames: " << options.frames << ", objects: " << scene.crateTransforms.size() + 3 << std::endl;
+    std::cout << "frame time (us): mean " << total/sorted.size()
+              << ", min " << sorted.front()
+              << ", median " << percentile(0.5)
+              << ", p95 " << percentile(0.95)
+              << ", p99 " << percentile(0.99)
+              << ", max " << sorted.back() << std::endl;
+    RenderCounters counters = GetRenderStatsInProgress();
+    std::cout << "per frame: " << counters.drawCalls << " draws, "
+              << counters.vertices << " vertices, "
+              << counters.materialSwitches << " material switches, "
+              << counters.matrixUploads << " matrix uploads" << std::endl;
+    std::cout << "checksum: " << checksum << std::endl;
+    if (options.csvFile && !statsLog.SaveCsv(options.csvFile))
+    {
+        std::cerr << "Could not write " << options.csvFile << std::endl;
+        return 1;
+    }
+    return 0;
 }
 
 int main(int argc, char* argv[])
 {
+    ExampleOptions options;
+    if (!ParseOptions(argc, argv, &options)) return 1;
+    if (options.headless) return RunHeadless(options);
+
     // Initialization
     //--------------------------------------------------------------------------------------
     const int screenWidth = 800;
@@ -46,41 +262,76 @@ int main(int argc, char* argv[])
     camera.projection = CAMERA_PERSPECTIVE;             // Camera mode type
     SetCameraMode(camera, CAMERA_FREE); // Set a free camera mode
 
-    // WORLD.
-    GameTransform worldTransform(
-        { 0.0, 0.0, 0.0 }, // Position
-        {{ 0.0, 1.0, 0.0 }, 0.0}, // Rotation
-        { 1.0, 1.0, 1.0 }  // Scale
+    // Orbiting camera mounted on a rig, F2 switches to it.
+    GameTransform cameraRig(
+        { 0.0, 0.0, 0.0 },
+        {{ 0.0, 1.0, 0.0 }, 0.0},
+        { 1.0, 1.0, 1.0 }
+    );
+    GameTransform cameraMount(
+        { 0.0, 6.0, 12.0 },
+        {{ 1.0, 0.0, 0.0 }, -26.57f},
+        { 1.0, 1.0, 1.0 }
     );
+    cameraMount.SetParent(&cameraRig);
+    TransformCamera orbitCamera(&cameraMount);
+    bool useOrbitCamera = false;
+    float orbit = 0.0f;
+
+    // SCENE.
+    ExampleScene scene(options.crateCount);
     Texture2D texture = LoadTexture("resources/Brick_0.png");
 
     // CUBE.
-    // Transform.
-    GameTransform cubeTransform(
-        { 1.0, 1.0, 1.0 }, // Position
-        {{ 1.0, 1.0, 1.0 }, 0.0 }, // Rotation
-        { 2.0, 2.0, 2.0 }  // Scale
-    );
-    cubeTransform.SetParent(&worldTransform);
-    // Model.
     Mesh cubeMesh = GenMeshCube(1.0f, 1.0f, 1.0f);
     Model cubeModel = LoadModelFromMesh(cubeMesh);
     cubeModel.materials[0].maps[MATERIAL_MAP_DIFFUSE].texture = texture;
-    
+    RenderModel cubeRender(cubeModel, &scene.cubeTransform, WHITE);
+
     // SPHERE.
-    // Transform.
-    GameTransform sphereTransform(
-        { 0.0, 1.0, 1.0 },
-        {{ 1.0, 1.0, 1.0 }, 0.0},
-        { 0.5, 0.5, 0.5 }
-    );
-    sphereTransform.SetParent(&cubeTransform);
-    // Model.
     Mesh sphereMesh = GenMeshSphere(1.0f, 10, 10);
     Model sphereModel = LoadModelFromMesh(sphereMesh);
     sphereModel.materials[0].maps[MATERIAL_MAP_DIFFUSE].texture = texture;
+    RenderModel sphereRender(sphereModel, &scene.sphereTransform, WHITE);
+
+    // CRATES.
+    // Instancing shader, takes the world matrix from a per-instance attribute.
+    Shader instancingShader = LoadShader("resources/shaders/instanced.vs", 0);
+    instancingShader.locs[SHADER_LOC_MATRIX_MVP] = GetShaderLocation(instancingShader, "mvp");
+    instancingShader.locs[SHADER_LOC_MATRIX_MODEL] = GetShaderLocationAttrib(instancingShader, "instanceTransform");
+    // Material shared by every crate, so all of them land in one batch.
+    Material crateMaterial = LoadMaterialDefault();
+    crateMaterial.shader = instancingShader;
+    crateMaterial.maps[MATERIAL_MAP_DIFFUSE].texture = texture;
+    // Instance matrices are drawn from one long-lived vertex buffer.
+    RlglInstanceRingBackend instanceRingBackend;
+    InstanceRing instanceRing(&instanceRingBackend, (int)scene.crateTransforms.size() + 16);
+    InstanceBatcher crateBatcher;
+    crateBatcher.SetInstanceRing(&instanceRing);
+
+    // Models are drawn through a sorted queue, grouped by shader and material.
+    RenderQueue renderQueue;
+    renderQueue.SetDepthRange(0.0f, 100.0f);
+    renderQueue.SetInstanceRing(&instanceRing);
 
+    // Debug lines, flushed in one batch. F1 toggles the hierarchy skeleton.
+    DebugDraw debugDraw;
+    bool showHierarchy = false;
+
+    // Readouts, reformatted only when a value changes at two decimals.
+    const int ypos = 50;
+    HudText hudText(10, BLACK);
+    int cubePositionLine = hudText.AddLine("Cube Pos: %3.2f %3.2f %3.2f", 2, 10, ypos + 15);
+    int cubeRotationLine = hudText.AddLine("Cube Rot: %3.2f %3.2f %3.2f %3.2f", 2, 10, ypos + 30);
+    int spherePositionLine = hudText.AddLine("Sphere Pos: %3.2f %3.2f %3.2f", 2, 10, ypos + 45);
+    int sphereRotationLine = hudText.AddLine("Sphere Rot: %3.2f %3.2f %3.2f %3.2f", 2, 10, ypos + 60);
+
+    // Simulation runs at 30 Hz, rendering blends between its last two steps.
+    FixedTimestep simulationClock(1.0f/30.0f);
+    TransformInterpolator interpolator;
     float spin = 0.0f;
+    SceneReadout readout = scene.Update(spin, 0.0f);
+    interpolator.Track(&scene.worldTransform);
 
     SetTargetFPS(60);
 
@@ -89,17 +340,33 @@ int main(int argc, char* argv[])
     {
         // Update
         //----------------------------------------------------------------------------------
+        BeginRenderStats();
         UpdateCamera(&camera);              // Update camera
-        // Get rotation.
-        worldTransform.SetLocalRotation({ {0.0, 1.0, 0.0}, spin * 0.5f });
-        cubeTransform.SetLocalRotation({ {1.0, 0.0, 1.0}, spin });
-        sphereTransform.SetLocalRotation({ {1.0, 1.0, 0.0}, spin });
-        RotationAxisAngle cubeRotation = cubeTransform.GetWorldRotation();
-        Vector3 cubePosition = cubeTransform.GetWorldPosition();
-        Vector3 cubeScale = cubeTransform.GetWorldScale();
-        RotationAxisAngle sphereRotation = sphereTransform.GetWorldRotation();
-        Vector3 spherePosition = sphereTransform.GetWorldPosition();
-        Vector3 sphereScale = sphereTransform.GetWorldScale();
+        if (IsKeyPressed(KEY_F1)) showHierarchy = !showHierarchy;
+        if (IsKeyPressed(KEY_F2)) useOrbitCamera = !useOrbitCamera;
+        if (useOrbitCamera)
+        {
+            orbit += 20.0f*GetFrameTime();
+            cameraRig.SetLocalRotation({ {0.0, 1.0, 0.0}, orbit });
+        }
+        Vector3 viewPosition = useOrbitCamera? orbitCamera.GetPosition() : camera.position;
+        int steps = simulationClock.Advance(GetFrameTime());
+        for (int step = 0; step < steps; step++)
+        {
+            // Same angular speed as one degree per frame at 60 FPS.
+            spin += 60.0f*simulationClock.GetStep();
+            readout = scene.Update(spin, simulationClock.GetStep());
+            interpolator.Capture();
+        }
+        interpolator.Interpolate(simulationClock.GetAlpha());
+        RotationAxisAngle cubeRotation = readout.cubeRotation;
+        Vector3 cubePosition = readout.cubePosition;
+        RotationAxisAngle sphereRotation = readout.sphereRotation;
+        Vector3 spherePosition = readout.spherePosition;
+        hudText.SetValues(cubePositionLine, { cubePosition.x, cubePosition.y, cubePosition.z });
+        hudText.SetValues(cubeRotationLine, { cubeRotation.axis.x, cubeRotation.axis.y, cubeRotation.axis.z, cubeRotation.angle });
+        hudText.SetValues(spherePositionLine, { spherePosition.x, spherePosition.y, spherePosition.z });
+        hudText.SetValues(sphereRotationLine, { sphereRotation.axis.x, sphereRotation.axis.y, sphereRotation.axis.z, sphereRotation.angle });
         
         //----------------------------------------------------------------------------------
 
@@ -109,43 +376,42 @@ int main(int argc, char* argv[])
 
             ClearBackground(RAYWHITE);
 
-            BeginMode3D(camera);
+            if (useOrbitCamera) orbitCamera.Begin();
+            else BeginMode3D(camera);
 
-                int ypos = 50;
-                
-                DrawModelPro(cubeModel, cubeTransform.GetLocalToWorldMatrix(), WHITE);
-                DrawModelPro(sphereModel, sphereTransform.GetLocalToWorldMatrix(), WHITE);
+                instanceRing.BeginFrame();
+                renderQueue.Begin();
+                renderQueue.Push(0, cubeRender, interpolator.GetWorldMatrix(&scene.cubeTransform),
+                                 Vector3Distance(viewPosition, cubePosition));
+                renderQueue.Push(0, sphereRender, interpolator.GetWorldMatrix(&scene.sphereTransform),
+                                 Vector3Distance(viewPosition, spherePosition));
+                renderQueue.Sort();
+                renderQueue.Submit();
 
-                DrawLine3D(cubePosition, Vector3Scale(cubeRotation.axis, 2.0), RED);
-                DrawLine3D(spherePosition, Vector3Scale(sphereRotation.axis, 2.0), BLUE);
-                
+                // One instanced draw call for every crate.
+                crateBatcher.Begin();
+                for (const std::unique_ptr<GameTransform>& crate: scene.crateTransforms)
+                {
+                    crateBatcher.Add(cubeModel.meshes[0], crateMaterial, interpolator.GetWorldMatrix(crate.get()));
+                }
+                crateBatcher.Draw();
+                instanceRing.EndFrame();
 
-                spin += 1.0f;
+                debugDraw.Begin();
+                debugDraw.Line(cubePosition, Vector3Scale(cubeRotation.axis, 2.0), RED);
+                debugDraw.Line(spherePosition, Vector3Scale(sphereRotation.axis, 2.0), BLUE);
+                if (showHierarchy) debugDraw.Hierarchy(scene.worldTransform, 0.5f, DARKGRAY);
+                debugDraw.Flush();
 
                 DrawGrid(10, 1.0f);
 
-            EndMode3D();
-
-            DrawText(TextFormat("Cube Pos: %3.2f %3.2f %3.2f",
-                                cubePosition.x,
-                                cubePosition.y,
-                                cubePosition.z), 10, ypos + 15, 10, BLACK);
-            DrawText(TextFormat("Cube Rot: %3.2f %3.2f %3.2f %3.2f",
-                                cubeRotation.axis.x,
-                                cubeRotation.axis.y,
-                                cubeRotation.axis.z,
-                                cubeRotation.angle), 10, ypos + 30, 10, BLACK);
-            DrawText(TextFormat("Sphere Pos: %3.2f %3.2f %3.2f",
-                                spherePosition.x,
-                                spherePosition.y,
-                                spherePosition.z), 10, ypos + 45, 10, BLACK);
-            DrawText(TextFormat("Sphere Rot: %3.2f %3.2f %3.2f %3.2f",
-                                sphereRotation.axis.x,
-                                sphereRotation.axis.y,
-                                sphereRotation.axis.z,
-                                sphereRotation.angle), 10, ypos + 60, 10, BLACK);
+            if (useOrbitCamera) orbitCamera.End();
+            else EndMode3D();
+
+            hudText.Draw();
 
             DrawFPS(10, 10);
+            DrawRenderStats(screenWidth - 220, 10);
 
         EndDrawing();
         //----------------------------------------------------------------------------------
@@ -153,6 +419,7 @@ int main(int argc, char* argv[])
 
     // De-Initialization
     //--------------------------------------------------------------------------------------
+    instanceRingBackend.Release();  // Unload the instance buffer while the context exists
     CloseWindow();        // Close window and OpenGL context
     //--------------------------------------------------------------------------------------
 
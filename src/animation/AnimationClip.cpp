@@ -0,0 +1,150 @@
+/*******************************************************************************************
+*
+*   AnimationClip.cpp
+*   Implementation of an AnimationClip and a ClipSampler.
+*
+*   LICENSE: GPLv3
+*
+*   Copyright (c) 2021 Juniper Dusk (@juniper-dusk)
+*
+*******************************************************************************************/
+
+#include "AnimationClip.h"
+#include "raymath.h"
+#include <algorithm>
+#include <cmath>
+
+namespace GameEngine
+{
+
+// Find the key at or before time, starting from the cursor and moving it there. Returns
+// the blend factor towards the next key.
+template <typename T>
+static inline float SeekChannel(const KeyChannel<T>& channel, float time, int& cursor)
+{
+    const float* times = channel.times.data();
+    int last = (int)channel.times.size() - 1;
+    // Sampling went backwards, start over from the first key.
+    if ((cursor > last) || (times[cursor] > time)) cursor = 0;
+    while ((cursor < last) && (times[cursor + 1] <= time))
+    {
+        cursor++;
+    }
+    if ((cursor == last) || (time <= times[cursor])) return 0.0f;
+    return (time - times[cursor])/(times[cursor + 1] - times[cursor]);
+}
+
+// Blends are written out rather than calling raymath, which this loop would otherwise call
+// several times per channel.
+static inline Vector3 SampleChannel(const KeyChannel<Vector3>& channel, float time, int& cursor)
+{
+    float alpha = SeekChannel(channel, time, cursor);
+    const Vector3& from = channel.values[cursor];
+    if (alpha == 0.0f) return from;
+    const Vector3& to = channel.values[cursor + 1];
+    return { from.x + alpha*(to.x - from.x), from.y + alpha*(to.y - from.y), from.z + alpha*(to.z - from.z) };
+}
+
+static inline Quaternion SampleChannel(const KeyChannel<Quaternion>& channel, float time, int& cursor)
+{
+    float alpha = SeekChannel(channel, time, cursor);
+    const Quaternion& from = channel.values[cursor];
+    if (alpha == 0.0f) return from;
+    // Nlerp along the shortest arc, keys are close enough for it to match slerp.
+    Quaternion to = channel.values[cursor + 1];
+    float dot = from.x*to.x + from.y*to.y + from.z*to.z + from.w*to.w;
+    float sign = (dot < 0.0f)? -1.0f : 1.0f;
+    Quaternion blended = {
+        from.x + alpha*(sign*to.x - from.x),
+        from.y + alpha*(sign*to.y - from.y),
+        from.z + alpha*(sign*to.z - from.z),
+        from.w + alpha*(sign*to.w - from.w)
+    };
+    float length = sqrtf(blended.x*blended.x + blended.y*blended.y + blended.z*blended.z + blended.w*blended.w);
+    float inverseLength = (length > 0.0f)? 1.0f/length : 1.0f;
+    return { blended.x*inverseLength, blended.y*inverseLength, blended.z*inverseLength, blended.w*inverseLength };
+}
+
+AnimationClip::AnimationClip(float duration, int trackCount) :
+    duration(duration),
+    tracks(trackCount)
+{
+}
+
+void AnimationClip::AddPositionKey(int track, float time, Vector3 position)
+{
+    tracks.at(track).positions.times.push_back(time);
+    tracks.at(track).positions.values.push_back(position);
+}
+
+void AnimationClip::AddRotationKey(int track, float time, Quaternion rotation)
+{
+    tracks.at(track).rotations.times.push_back(time);
+    tracks.at(track).rotations.values.push_back(rotation);
+}
+
+void AnimationClip::AddScaleKey(int track, float time, Vector3 scale)
+{
+    tracks.at(track).scales.times.push_back(time);
+    tracks.at(track).scales.values.push_back(scale);
+}
+
+float AnimationClip::GetDuration() const
+{
+    return duration;
+}
+
+int AnimationClip::GetTrackCount() const
+{
+    return (int)tracks.size();
+}
+
+const ClipTrack& AnimationClip::GetTrack(int track) const
+{
+    return tracks.at(track);
+}
+
+ClipSampler::ClipSampler(const AnimationClip* clip) :
+    clip(nullptr)
+{
+    SetClip(clip);
+}
+
+const AnimationClip* ClipSampler::GetClip() const
+{
+    return clip;
+}
+
+void ClipSampler::SetClip(const AnimationClip* clip)
+{
+    this->clip = clip;
+    cursors.assign(clip? clip->GetTrackCount()*3 : 0, 0);
+}
+
+void ClipSampler::Sample(float time, Pose& pose)
+{
+    Sample(time, pose.GetBuffer());
+}
+
+void ClipSampler::Sample(float time, PoseBuffer pose)
+{
+    time = Clamp(time, 0.0f, clip->GetDuration());
+    int trackCount = clip->GetTrackCount();
+    if (trackCount == 0) return;
+    const ClipTrack* tracks = &clip->GetTrack(0);
+    for (int i = 0; i < trackCount; i++)
+    {
+        const ClipTrack& track = tracks[i];
+        int* cursor = &cursors[i*3];
+        if (!track.positions.times.empty()) pose.positions[i] = SampleChannel(track.positions, time, cursor[0]);
+        if (!track.rotations.times.empty()) pose.rotations[i] = SampleChannel(track.rotations, time, cursor[1]);
+        if (!track.scales.times.empty()) pose.scales[i] = SampleChannel(track.scales, time, cursor[2]);
+    }
+}
+
+void ClipSampler::Reset()
+{
+    std::fill(cursors.begin(), cursors.end(), 0);
+}
+
+}
@@ -0,0 +1,90 @@
+/*******************************************************************************************
+*
+*   AnimationClip.h
+*   Definition of an AnimationClip and a ClipSampler. A clip holds one track per animated
+*   transform, each with its own position, rotation and scale keyframes. The sampler
+*   evaluates every track at a time straight into a Pose, keeping a cursor per channel at
+*   the last key it used: playing forward only ever steps the cursor ahead, so sequential
+*   sampling never searches for keys.
+*
+*   LICENSE: GPLv3
+*
+*   Copyright (c) 2021 Juniper Dusk (@juniper-dusk)
+*
+*******************************************************************************************/
+
+#ifndef ANIMATIONCLIP_H
+#define ANIMATIONCLIP_H
+
+#include "raylib.h"
+#include "Pose.h"
+#include <vector>
+
+namespace GameEngine
+{
+
+// Keyframes of one channel, in increasing time order.
+template <typename T>
+struct KeyChannel
+{
+    std::vector<float> times;
+    std::vector<T> values;
+};
+
+// Channels of one animated transform. Empty channels leave the pose untouched.
+typedef struct ClipTrack
+{
+    KeyChannel<Vector3> positions;
+    KeyChannel<Quaternion> rotations;
+    KeyChannel<Vector3> scales;
+} ClipTrack;
+
+class AnimationClip
+{
+public:
+    // INITIALIZATION.
+    // Track n animates pose entry n.
+    AnimationClip(float duration, int trackCount);
+
+    // KEYFRAMES.
+    // Keys of a channel must be added in increasing time order.
+    void AddPositionKey(int track, float time, Vector3 position);
+    void AddRotationKey(int track, float time, Quaternion rotation);
+    void AddScaleKey(int track, float time, Vector3 scale);
+
+    // QUERIES.
+    float GetDuration() const;
+    int GetTrackCount() const;
+    const ClipTrack& GetTrack(int track) const;
+
+protected:
+    float duration;
+    std::vector<ClipTrack> tracks;
+};
+
+class ClipSampler
+{
+public:
+    // INITIALIZATION.
+    ClipSampler(const AnimationClip* clip);
+
+    const AnimationClip* GetClip() const;
+    void SetClip(const AnimationClip* clip);
+
+    // SAMPLING.
+    // Write every track at time, clamped to the clip, into the pose. The pose must have
+    // an entry per track.
+    void Sample(float time, Pose& pose);
+    void Sample(float time, PoseBuffer pose);
+    // Forget the cursors, for a jump backwards in time.
+    void Reset();
+
+protected:
+    const AnimationClip* clip;
+    // Key index before the last sampled time, per channel: position, rotation, scale.
+    std::vector<int> cursors;
+};
+
+}
+
+#endif // ANIMATIONCLIP_H
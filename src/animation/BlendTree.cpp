@@ -0,0 +1,172 @@
+/*******************************************************************************************
+*
+*   BlendTree.cpp
+*   Implementation of a BlendTree.
+*
+*   LICENSE: GPLv3
+*
+*   Copyright (c) 2021 Juniper Dusk (@juniper-dusk)
+*
+*******************************************************************************************/
+
+#include "BlendTree.h"
+#include "PoseBlend.h"
+
+namespace GameEngine
+{
+
+BlendTree::BlendTree(int boneCount) :
+    boneCount(boneCount),
+    restPose(boneCount)
+{
+}
+
+int BlendTree::GetBoneCount() const
+{
+    return boneCount;
+}
+
+void BlendTree::SetRestPose(const Pose& pose)
+{
+    restPose = pose;
+    restPose.Resize(boneCount);
+}
+
+int BlendTree::AddClip(ClipSampler* sampler)
+{
+    int index = AddNode(NODE_CLIP);
+    nodes[index].sampler = sampler;
+    return index;
+}
+
+int BlendTree::AddCompressedClip(const CompressedClip* clip)
+{
+    int index = AddNode(NODE_COMPRESSED_CLIP);
+    nodes[index].compressed = clip;
+    return index;
+}
+
+int BlendTree::AddBlend(const std::vector<int>& children)
+{
+    int index = AddNode(NODE_BLEND);
+    nodes[index].children = children;
+    nodes[index].weights.assign(children.size(), 1.0f);
+    return index;
+}
+
+int BlendTree::AddLayer(int base, int layer)
+{
+    int index = AddNode(NODE_LAYER);
+    nodes[index].children = { base, layer };
+    return index;
+}
+
+int BlendTree::AddAdditive(int base, int additive, Pose* reference)
+{
+    int index = AddNode(NODE_ADDITIVE);
+    nodes[index].children = { base, additive };
+    nodes[index].reference = reference;
+    return index;
+}
+
+void BlendTree::SetTime(int node, float time)
+{
+    nodes.at(node).time = time;
+}
+
+void BlendTree::SetChildWeight(int node, int child, float weight)
+{
+    nodes.at(node).weights.at(child) = weight;
+}
+
+void BlendTree::SetWeight(int node, float weight)
+{
+    nodes.at(node).weight = weight;
+}
+
+void BlendTree::SetMask(int node, const float* mask)
+{
+    if (mask) nodes.at(node).mask.assign(mask, mask + boneCount);
+    else nodes.at(node).mask.clear();
+}
+
+void BlendTree::SetSlerp(int node, bool slerp)
+{
+    nodes.at(node).slerp = slerp;
+}
+
+void BlendTree::Evaluate(int root, FrameArena& arena, PoseBuffer output)
+{
+    CopyPose(EvaluateNode(root, arena), output);
+}
+
+int BlendTree::AddNode(NodeType type)
+{
+    Node node = { };
+    node.type = type;
+    node.weight = 1.0f;
+    nodes.push_back(node);
+    return (int)nodes.size() - 1;
+}
+
+PoseBuffer BlendTree::EvaluateNode(int index, FrameArena& arena)
+{
+    Node& node = nodes[index];
+    const float* mask = node.mask.empty()? nullptr : node.mask.data();
+
+    switch (node.type)
+    {
+        case NODE_CLIP:
+        case NODE_COMPRESSED_CLIP:
+        {
+            PoseBuffer pose = arena.AllocatePose(boneCount);
+            CopyPose(restPose.GetBuffer(), pose);
+            if (node.type == NODE_CLIP) node.sampler->Sample(node.time, pose);
+            else node.compressed->Sample(node.time, pose, node.cursors);
+            return pose;
+        }
+        case NODE_BLEND:
+        {
+            // Only children that contribute are evaluated.
+            PoseBuffer* inputs = arena.Allocate<PoseBuffer>(node.children.size());
+            float* weights = arena.Allocate<float>(node.children.size());
+            int count = 0;
+            for (size_t child = 0; child < node.children.size(); child++)
+            {
+                if (node.weights[child] <= 0.0f) continue;
+                inputs[count] = EvaluateNode(node.children[child], arena);
+                weights[count] = node.weights[child];
+                count++;
+            }
+            if (count == 0)
+            {
+                PoseBuffer pose = arena.AllocatePose(boneCount);
+                CopyPose(restPose.GetBuffer(), pose);
+                return pose;
+            }
+            // Blend in place over the first child's pose.
+            BlendPoses(inputs, weights, count, inputs[0]);
+            return inputs[0];
+        }
+        case NODE_LAYER:
+        {
+            PoseBuffer base = EvaluateNode(node.children[0], arena);
+            if (node.weight <= 0.0f) return base;
+            PoseBuffer layer = EvaluateNode(node.children[1], arena);
+            LerpPoses(base, layer, node.weight, mask, node.slerp, base);
+            return base;
+        }
+        case NODE_ADDITIVE:
+        {
+            PoseBuffer base = EvaluateNode(node.children[0], arena);
+            if (node.weight <= 0.0f) return base;
+            PoseBuffer additive = EvaluateNode(node.children[1], arena);
+            PoseBuffer reference = node.reference->GetBuffer();
+            AddPoses(base, additive, reference, node.weight, mask, base);
+            return base;
+        }
+    }
+    return arena.AllocatePose(boneCount);
+}
+
+}
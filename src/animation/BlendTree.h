@@ -0,0 +1,103 @@
+/*******************************************************************************************
+*
+*   BlendTree.h
+*   Definition of a BlendTree. Nodes sample clips or combine the poses of other nodes:
+*     - blend nodes average any number of children by weight,
+*     - layer nodes move a base pose towards a layer pose, optionally per bone masked,
+*     - additive nodes add a layer's difference from a reference pose onto a base pose.
+*   Evaluation walks the tree once, skipping children without weight. Every intermediate
+*   pose comes from a FrameArena, so a frame of blending allocates nothing.
+*
+*   LICENSE: GPLv3
+*
+*   Copyright (c) 2021 Juniper Dusk (@juniper-dusk)
+*
+*******************************************************************************************/
+
+#ifndef BLENDTREE_H
+#define BLENDTREE_H
+
+#include "raylib.h"
+#include "AnimationClip.h"
+#include "CompressedClip.h"
+#include "FrameArena.h"
+#include "Pose.h"
+#include <vector>
+
+namespace GameEngine
+{
+
+class BlendTree
+{
+public:
+    // INITIALIZATION.
+    // Poses of boneCount transforms. Channels no clip animates keep the rest pose.
+    BlendTree(int boneCount);
+    // Disallow copies.
+    BlendTree(const BlendTree& copy) = delete;
+
+    int GetBoneCount() const;
+    void SetRestPose(const Pose& pose);
+
+    // NODES.
+    // Every call returns the new node's index. Children must be added first.
+    int AddClip(ClipSampler* sampler);
+    int AddCompressedClip(const CompressedClip* clip);
+    // Children start with a weight of one.
+    int AddBlend(const std::vector<int>& children);
+    int AddLayer(int base, int layer);
+    // Reference must outlive the tree.
+    int AddAdditive(int base, int additive, Pose* reference);
+
+    // PARAMETERS.
+    // Sampling time of a clip node.
+    void SetTime(int node, float time);
+    // Weight of a child of a blend node.
+    void SetChildWeight(int node, int child, float weight);
+    // Weight of a layer or additive node's layer.
+    void SetWeight(int node, float weight);
+    // Per bone factor on a layer or additive node's weight, boneCount values, or NULL.
+    void SetMask(int node, const float* mask);
+    // Slerp instead of nlerp on a layer node.
+    void SetSlerp(int node, bool slerp);
+
+    // EVALUATION.
+    // Evaluate a node and write its pose into output.
+    void Evaluate(int root, FrameArena& arena, PoseBuffer output);
+
+protected:
+    typedef enum NodeType
+    {
+        NODE_CLIP = 0,
+        NODE_COMPRESSED_CLIP,
+        NODE_BLEND,
+        NODE_LAYER,
+        NODE_ADDITIVE
+    } NodeType;
+
+    typedef struct Node
+    {
+        NodeType type;
+        std::vector<int> children;
+        std::vector<float> weights;
+        float weight;
+        std::vector<float> mask;
+        bool slerp;
+        float time;
+        ClipSampler* sampler;
+        const CompressedClip* compressed;
+        std::vector<int> cursors;
+        Pose* reference;
+    } Node;
+
+    int boneCount;
+    Pose restPose;
+    std::vector<Node> nodes;
+
+    int AddNode(NodeType type);
+    PoseBuffer EvaluateNode(int index, FrameArena& arena);
+};
+
+}
+
+#endif // BLENDTREE_H
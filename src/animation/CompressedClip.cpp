@@ -0,0 +1,641 @@
+/*******************************************************************************************
+*
+*   CompressedClip.cpp
+*   Implementation of a CompressedClip.
+*
+*   LICENSE: GPLv3
+*
+*   Copyright (c) 2021 Juniper Dusk (@juniper-dusk)
+*
+*******************************************************************************************/
+
+#include "CompressedClip.h"
+#include "raymath.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+// Keys are decoded four channels at a time with SSE2, which every x86-64 CPU has.
+#if defined(__SSE2__) || defined(_M_X64)
+    #define COMPRESSEDCLIP_SSE2
+    #include <emmintrin.h>
+#endif
+
+namespace GameEngine
+{
+
+// Smallest three components of a unit quaternion lie within this of zero.
+static const float smallestThreeRange = 0.70710678f;
+
+static float KeyError(Vector3 a, Vector3 b)
+{
+    return Vector3Distance(a, b);
+}
+
+static float KeyError(Quaternion a, Quaternion b)
+{
+    // Angle of the rotation between the two, either sign of a quaternion is the same. Taken
+    // from the chord between them, since acos of their dot product cannot resolve the
+    // small angles tolerances are made of in float.
+    float dot = a.x*b.x + a.y*b.y + a.z*b.z + a.w*b.w;
+    if (dot < 0.0f) b = QuaternionScale(b, -1.0f);
+    float chord = QuaternionLength({ a.x - b.x, a.y - b.y, a.z - b.z, a.w - b.w });
+    return 4.0f*asinf(std::min(0.5f*chord, 1.0f));
+}
+
+static Vector3 KeyLerp(Vector3 a, Vector3 b, float alpha)
+{
+    return Vector3Lerp(a, b, alpha);
+}
+
+static Quaternion KeyLerp(Quaternion a, Quaternion b, float alpha)
+{
+    float dot = a.x*b.x + a.y*b.y + a.z*b.z + a.w*b.w;
+    if (dot < 0.0f) b = QuaternionScale(b, -1.0f);
+    return QuaternionNormalize(QuaternionLerp(a, b, alpha));
+}
+
+// Indices of the keys to keep: one for a constant channel, otherwise every key that its
+// kept neighbours do not reproduce within tolerance.
+template <typename T>
+static std::vector<int> ReduceKeys(const KeyChannel<T>& channel, float tolerance)
+{
+    const std::vector<float>& times = channel.times;
+    const std::vector<T>& values = channel.values;
+    int count = (int)times.size();
+
+    bool constant = true;
+    for (int i = 1; (i < count) && constant; i++)
+    {
+        constant = (KeyError(values[i], values[0]) <= tolerance);
+    }
+    if (constant) return { 0 };
+
+    std::vector<int> kept = { 0 };
+    int start = 0;
+    for (int end = 2; end < count; end++)
+    {
+        // Could a segment from the last kept key to end replace every key in between?
+        bool fits = true;
+        for (int i = start + 1; (i < end) && fits; i++)
+        {
+            float alpha = (times[i] - times[start])/(times[end] - times[start]);
+            fits = (KeyError(KeyLerp(values[start], values[end], alpha), values[i]) <= tolerance);
+        }
+        if (!fits)
+        {
+            start = end - 1;
+            kept.push_back(start);
+        }
+    }
+    if (count > 1) kept.push_back(count - 1);
+    return kept;
+}
+
+static void ComputeVectorRange(const std::vector<Vector3>& values, const std::vector<int>& kept, Vector3& rangeMin, Vector3& rangeExtent)
+{
+    Vector3 rangeMax = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+    rangeMin = { FLT_MAX, FLT_MAX, FLT_MAX };
+    for (int key: kept)
+    {
+        rangeMin = Vector3Min(rangeMin, values[key]);
+        rangeMax = Vector3Max(rangeMax, values[key]);
+    }
+    rangeExtent = Vector3Subtract(rangeMax, rangeMin);
+}
+
+// Worst distance between a vector and its decoded key: half a 16 bit step on every
+// component. Kept keys span at most the range of all keys, so that range bounds it.
+static float VectorQuantizationError(const std::vector<Vector3>& values)
+{
+    std::vector<int> all(values.size());
+    for (int i = 0; i < (int)all.size(); i++) all[i] = i;
+    Vector3 rangeMin, rangeExtent;
+    ComputeVectorRange(values, all, rangeMin, rangeExtent);
+    return 0.5f*Vector3Length(rangeExtent)/65535.0f;
+}
+
+// Worst angle between a rotation and its decoded key. Each stored component is off by
+// half a 15 bit step, the rebuilt largest one by up to twice their combined error, so the
+// quaternions are at most three half steps apart, and the angle is twice that distance.
+static float RotationQuantizationError()
+{
+    float halfStep = smallestThreeRange/32767.0f;
+    return 2.0f*3.0f*halfStep;
+}
+
+// Worst error from storing key times in 16 bits. Every key moves by at most half a step,
+// which samples the decoded channel at most that far from the intended time, so the error
+// is bounded by the fastest change between keys. Decoded keys may each be off by
+// quantizationError, and blending may be up to blendRate times faster than the average
+// change over a segment.
+template <typename T>
+static float TimeQuantizationError(const KeyChannel<T>& channel, float duration, float quantizationError, float blendRate)
+{
+    float rate = 0.0f;
+    for (size_t i = 1; i < channel.times.size(); i++)
+    {
+        float interval = channel.times[i] - channel.times[i - 1];
+        if (interval <= 0.0f) continue;
+        rate = std::max(rate, (KeyError(channel.values[i], channel.values[i - 1]) + 2.0f*quantizationError)/interval);
+    }
+    float halfStep = 0.5f*duration/65535.0f;
+    return halfStep*blendRate*rate;
+}
+
+static uint16_t QuantizeUnit(float value, int bits)
+{
+    float levels = (float)((1 << bits) - 1);
+    return (uint16_t)lroundf(Clamp(value, 0.0f, 1.0f)*levels);
+}
+
+static void EncodeVectorKey(Vector3 value, Vector3 rangeMin, Vector3 rangeExtent, uint16_t* output)
+{
+    const float* components = &value.x;
+    const float* mins = &rangeMin.x;
+    const float* extents = &rangeExtent.x;
+    for (int i = 0; i < 3; i++)
+    {
+        output[i] = (extents[i] > 0.0f)? QuantizeUnit((components[i] - mins[i])/extents[i], 16) : 0;
+    }
+}
+
+static void EncodeRotationKey(Quaternion value, uint16_t* output)
+{
+    float components[4] = { value.x, value.y, value.z, value.w };
+    int largest = 0;
+    for (int i = 1; i < 4; i++)
+    {
+        if (fabsf(components[i]) > fabsf(components[largest])) largest = i;
+    }
+    // Make the largest component positive, so its sign need not be stored.
+    float sign = (components[largest] < 0.0f)? -1.0f : 1.0f;
+    int slot = 0;
+    for (int i = 0; i < 4; i++)
+    {
+        if (i == largest) continue;
+        float unit = (sign*components[i]/smallestThreeRange)*0.5f + 0.5f;
+        output[slot++] = QuantizeUnit(unit, 15);
+    }
+    // Largest component index goes in the spare top bits of the first two values.
+    output[0] |= (uint16_t)((largest >> 1) << 15);
+    output[1] |= (uint16_t)((largest & 1) << 15);
+}
+
+CompressedClip::CompressedClip(const AnimationClip& clip, CompressionTolerance tolerance) :
+    CompressedClip(clip, std::vector<CompressionTolerance>(clip.GetTrackCount(), tolerance))
+{
+}
+
+CompressedClip::CompressedClip(const AnimationClip& clip, const std::vector<CompressionTolerance>& trackTolerances) :
+    duration(clip.GetDuration()),
+    trackCount(clip.GetTrackCount())
+{
+    for (int i = 0; i < trackCount; i++)
+    {
+        const ClipTrack& track = clip.GetTrack(i);
+        AddVectorChannel(track.positions, trackTolerances[i].position);
+        AddRotationChannel(track.rotations, trackTolerances[i].rotation);
+        AddVectorChannel(track.scales, trackTolerances[i].scale);
+    }
+    keyTimes.shrink_to_fit();
+    keyValues.shrink_to_fit();
+}
+
+CompressedClip CompressedClip::CompressToWorldError(const AnimationClip& clip, const Pose& basePose, const int* parents,
+                                                    float maxWorldError, float sampleRate, CompressionTolerance tolerance)
+{
+    int trackCount = clip.GetTrackCount();
+    std::vector<CompressionTolerance> trackTolerances(trackCount, tolerance);
+    CompressedClip compressed(clip, trackTolerances);
+    std::vector<float> trackErrors;
+    std::vector<bool> tighten(trackCount);
+
+    for (int round = 0; round < maxRounds; round++)
+    {
+        compressed.MeasureTrackErrors(clip, basePose, parents, sampleRate, trackErrors);
+        // A joint's error builds up along its chain, so tighten the whole chain.
+        std::fill(tighten.begin(), tighten.end(), false);
+        bool missed = false;
+        for (int i = trackCount - 1; i >= 0; i--)
+        {
+            if (trackErrors[i] > maxWorldError) tighten[i] = true;
+            if (tighten[i] && (parents[i] >= 0)) tighten[parents[i]] = true;
+            missed = missed || tighten[i];
+        }
+        if (!missed) break;
+
+        for (int i = 0; i < trackCount; i++)
+        {
+            if (!tighten[i]) continue;
+            trackTolerances[i].position *= 0.5f;
+            trackTolerances[i].rotation *= 0.5f;
+            trackTolerances[i].scale *= 0.5f;
+        }
+        compressed = CompressedClip(clip, trackTolerances);
+    }
+    return compressed;
+}
+
+void CompressedClip::Sample(float time, Pose& pose, std::vector<int>& cursors) const
+{
+    Sample(time, pose.GetBuffer(), cursors);
+}
+
+void CompressedClip::Sample(float time, PoseBuffer pose, std::vector<int>& cursors) const
+{
+    if (cursors.size() < channels.size()) cursors.resize(channels.size(), 0);
+    // Sample time in units of quantized key times.
+    float keyTime = (duration > 0.0f)? Clamp(time/duration, 0.0f, 1.0f)*65535.0f : 0.0f;
+
+    // Seek every channel on its own, then decode the keys found across tracks together.
+    DecodeBatch vectors;
+    DecodeBatch rotations;
+    vectors.count = 0;
+    rotations.count = 0;
+    for (int i = 0; i < trackCount; i++)
+    {
+        const Channel* channel = &channels[i*3];
+        int* cursor = &cursors[i*3];
+
+        if (channel[0].keyCount > 0)
+        {
+            QueueKey(vectors, channel[0], keyTime, cursor[0], &pose.positions[i].x);
+            if (vectors.count == decodeLanes) DecodeVectors(vectors);
+        }
+        if (channel[1].keyCount > 0)
+        {
+            QueueKey(rotations, channel[1], keyTime, cursor[1], &pose.rotations[i].x);
+            if (rotations.count == decodeLanes) DecodeRotations(rotations);
+        }
+        if (channel[2].keyCount > 0)
+        {
+            QueueKey(vectors, channel[2], keyTime, cursor[2], &pose.scales[i].x);
+            if (vectors.count == decodeLanes) DecodeVectors(vectors);
+        }
+    }
+    DecodeVectors(vectors);
+    DecodeRotations(rotations);
+}
+
+float CompressedClip::GetDuration() const
+{
+    return duration;
+}
+
+int CompressedClip::GetTrackCount() const
+{
+    return trackCount;
+}
+
+size_t CompressedClip::GetKeyCount() const
+{
+    return keyTimes.size();
+}
+
+size_t CompressedClip::GetMemorySize() const
+{
+    return channels.size()*sizeof(Channel) + keyTimes.size()*sizeof(uint16_t) + keyValues.size()*sizeof(uint16_t);
+}
+
+size_t CompressedClip::GetMemorySize(const AnimationClip& clip)
+{
+    size_t size = 0;
+    for (int i = 0; i < clip.GetTrackCount(); i++)
+    {
+        const ClipTrack& track = clip.GetTrack(i);
+        size += track.positions.times.size()*(sizeof(float) + sizeof(Vector3));
+        size += track.rotations.times.size()*(sizeof(float) + sizeof(Quaternion));
+        size += track.scales.times.size()*(sizeof(float) + sizeof(Vector3));
+    }
+    return size;
+}
+
+float CompressedClip::MeasureWorldError(const AnimationClip& clip, const Pose& basePose, const int* parents, float sampleRate) const
+{
+    std::vector<float> trackErrors;
+    MeasureTrackErrors(clip, basePose, parents, sampleRate, trackErrors);
+    float maxError = 0.0f;
+    for (float error: trackErrors)
+    {
+        maxError = std::max(maxError, error);
+    }
+    return maxError;
+}
+
+void CompressedClip::MeasureTrackErrors(const AnimationClip& clip, const Pose& basePose, const int* parents, float sampleRate,
+                                        std::vector<float>& trackErrors) const
+{
+    Pose reference = basePose;
+    Pose decoded = basePose;
+    ClipSampler sampler(&clip);
+    std::vector<int> cursors;
+    std::vector<Matrix> referenceWorld(trackCount);
+    std::vector<Matrix> decodedWorld(trackCount);
+    trackErrors.assign(trackCount, 0.0f);
+
+    // Regular samples, plus every source and decoded key time: between them both clips
+    // blend linearly, so the error of every channel peaks at one of them.
+    std::vector<float> times;
+    int sampleCount = (int)ceilf(duration*sampleRate);
+    for (int sample = 0; sample <= sampleCount; sample++)
+    {
+        times.push_back(std::min(duration, sample/sampleRate));
+    }
+    for (int i = 0; i < trackCount; i++)
+    {
+        const ClipTrack& track = clip.GetTrack(i);
+        times.insert(times.end(), track.positions.times.begin(), track.positions.times.end());
+        times.insert(times.end(), track.rotations.times.begin(), track.rotations.times.end());
+        times.insert(times.end(), track.scales.times.begin(), track.scales.times.end());
+    }
+    for (uint16_t keyTime: keyTimes)
+    {
+        times.push_back(duration*(keyTime/65535.0f));
+    }
+    std::sort(times.begin(), times.end());
+    times.erase(std::unique(times.begin(), times.end()), times.end());
+
+    for (float time: times)
+    {
+        sampler.Sample(time, reference);
+        Sample(time, decoded, cursors);
+        for (int i = 0; i < trackCount; i++)
+        {
+            Matrix referenceLocal = GameTransform::ComposeMatrix(reference.positions[i], reference.rotations[i], reference.scales[i]);
+            Matrix decodedLocal = GameTransform::ComposeMatrix(decoded.positions[i], decoded.rotations[i], decoded.scales[i]);
+            if (parents[i] >= 0)
+            {
+                referenceLocal = MatrixMultiply(referenceLocal, referenceWorld[parents[i]]);
+                decodedLocal = MatrixMultiply(decodedLocal, decodedWorld[parents[i]]);
+            }
+            referenceWorld[i] = referenceLocal;
+            decodedWorld[i] = decodedLocal;
+            float error = Vector3Distance(GameTransform::ExtractTranslation(referenceLocal), GameTransform::ExtractTranslation(decodedLocal));
+            trackErrors[i] = std::max(trackErrors[i], error);
+        }
+    }
+}
+
+void CompressedClip::AddVectorChannel(const KeyChannel<Vector3>& source, float tolerance)
+{
+    Channel channel = { (uint32_t)keyTimes.size(), 0, { 0.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 0.0f } };
+    if (!source.times.empty())
+    {
+        // Reduction gets what quantization of the values and key times leaves of the tolerance.
+        float quantization = VectorQuantizationError(source.values);
+        float timeQuantization = TimeQuantizationError(source, duration, quantization, 1.0f);
+        float reduction = std::max(0.0f, tolerance - quantization - timeQuantization);
+        std::vector<int> kept = ReduceKeys(source, reduction);
+        ComputeVectorRange(source.values, kept, channel.rangeMin, channel.rangeExtent);
+        for (int key: kept)
+        {
+            AddKeyTime(source.times[key]);
+            uint16_t encoded[3];
+            EncodeVectorKey(source.values[key], channel.rangeMin, channel.rangeExtent, encoded);
+            keyValues.insert(keyValues.end(), encoded, encoded + 3);
+        }
+        channel.keyCount = (uint32_t)kept.size();
+    }
+    channels.push_back(channel);
+}
+
+void CompressedClip::AddRotationChannel(const KeyChannel<Quaternion>& source, float tolerance)
+{
+    Channel channel = { (uint32_t)keyTimes.size(), 0, { 0.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 0.0f } };
+    if (!source.times.empty())
+    {
+        // Nlerp turns up to 4/pi times faster than slerp over the same segment.
+        float quantization = RotationQuantizationError();
+        float timeQuantization = TimeQuantizationError(source, duration, quantization, 4.0f/PI);
+        float reduction = std::max(0.0f, tolerance - quantization - timeQuantization);
+        std::vector<int> kept = ReduceKeys(source, reduction);
+        for (int key: kept)
+        {
+            AddKeyTime(source.times[key]);
+            uint16_t encoded[3];
+            EncodeRotationKey(source.values[key], encoded);
+            keyValues.insert(keyValues.end(), encoded, encoded + 3);
+        }
+        channel.keyCount = (uint32_t)kept.size();
+    }
+    channels.push_back(channel);
+}
+
+void CompressedClip::AddKeyTime(float time)
+{
+    float unitTime = (duration > 0.0f)? time/duration : 0.0f;
+    keyTimes.push_back(QuantizeUnit(unitTime, 16));
+}
+
+int CompressedClip::SeekChannel(const Channel& channel, float time, int& cursor, float& alpha) const
+{
+    const uint16_t* times = &keyTimes[channel.firstKey];
+    int last = (int)channel.keyCount - 1;
+    alpha = 0.0f;
+    if ((cursor > last) || (times[cursor] > time)) cursor = 0;
+    while ((cursor < last) && (times[cursor + 1] <= time))
+    {
+        cursor++;
+    }
+    if ((cursor < last) && (time > times[cursor]))
+    {
+        alpha = (time - times[cursor])/(float)(times[cursor + 1] - times[cursor]);
+    }
+    return (int)channel.firstKey + cursor;
+}
+
+void CompressedClip::QueueKey(DecodeBatch& batch, const Channel& channel, float time, int& cursor, float* output) const
+{
+    int lane = batch.count++;
+    float alpha = 0.0f;
+    uint32_t key = (uint32_t)SeekChannel(channel, time, cursor, alpha);
+    batch.channels[lane] = &channel;
+    batch.keys[lane] = key;
+    batch.nextKeys[lane] = (alpha > 0.0f)? key + 1 : key;
+    batch.alphas[lane] = alpha;
+    batch.outputs[lane] = output;
+}
+
+#ifdef COMPRESSEDCLIP_SSE2
+// Component of the keys of four channels as floats.
+static inline __m128 LoadKeyComponents(const uint16_t* values, const uint32_t* keys, int component)
+{
+    return _mm_cvtepi32_ps(_mm_setr_epi32(values[keys[0]*3 + component], values[keys[1]*3 + component],
+                                          values[keys[2]*3 + component], values[keys[3]*3 + component]));
+}
+
+static inline __m128 Select(__m128 mask, __m128 a, __m128 b)
+{
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+// Components x, y, z and w of four rotation keys, one key per lane. Same arithmetic as
+// CompressedClip::DecodeRotation().
+static inline void DecodeRotationLanes(const uint16_t* keyValues, const uint32_t* keys, __m128* components)
+{
+    const __m128i mask = _mm_set1_epi32(0x7FFF);
+    __m128i values[3];
+    for (int i = 0; i < 3; i++)
+    {
+        values[i] = _mm_setr_epi32(keyValues[keys[0]*3 + i], keyValues[keys[1]*3 + i],
+                                   keyValues[keys[2]*3 + i], keyValues[keys[3]*3 + i]);
+    }
+    __m128i largest = _mm_or_si128(_mm_slli_epi32(_mm_srli_epi32(values[0], 15), 1), _mm_srli_epi32(values[1], 15));
+
+    const __m128 scale = _mm_set1_ps(2.0f*smallestThreeRange/32767.0f);
+    const __m128 range = _mm_set1_ps(smallestThreeRange);
+    __m128 small[3];
+    for (int i = 0; i < 3; i++)
+    {
+        small[i] = _mm_sub_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(values[i], mask)), scale), range);
+    }
+    __m128 rest = _mm_sub_ps(_mm_sub_ps(_mm_sub_ps(_mm_set1_ps(1.0f), _mm_mul_ps(small[0], small[0])),
+                                        _mm_mul_ps(small[1], small[1])), _mm_mul_ps(small[2], small[2]));
+    __m128 rebuilt = _mm_sqrt_ps(_mm_max_ps(rest, _mm_setzero_ps()));
+
+    // Component c is the rebuilt one, or the stored one in slot c - 1 after the largest
+    // component, or slot c before it.
+    for (int c = 0; c < 4; c++)
+    {
+        __m128 isLargest = _mm_castsi128_ps(_mm_cmpeq_epi32(largest, _mm_set1_epi32(c)));
+        __m128 after = _mm_castsi128_ps(_mm_cmplt_epi32(largest, _mm_set1_epi32(c)));
+        __m128 stored = (c == 0)? small[0] : (c == 3)? small[2] : Select(after, small[c - 1], small[c]);
+        components[c] = Select(isLargest, rebuilt, stored);
+    }
+}
+#endif
+
+void CompressedClip::DecodeVectors(DecodeBatch& batch) const
+{
+#ifdef COMPRESSEDCLIP_SSE2
+    if (batch.count == decodeLanes)
+    {
+        // Same arithmetic as DecodeVector() and Vector3Lerp(), one component of four keys
+        // at a time. A lane with no blend decodes its key twice and keeps it.
+        const Channel* const* lanes = batch.channels;
+        const __m128 scale = _mm_set1_ps(1.0f/65535.0f);
+        const __m128 alpha = _mm_loadu_ps(batch.alphas);
+        float decoded[3][decodeLanes];
+        for (int c = 0; c < 3; c++)
+        {
+            __m128 mins = _mm_setr_ps((&lanes[0]->rangeMin.x)[c], (&lanes[1]->rangeMin.x)[c],
+                                      (&lanes[2]->rangeMin.x)[c], (&lanes[3]->rangeMin.x)[c]);
+            __m128 extents = _mm_setr_ps((&lanes[0]->rangeExtent.x)[c], (&lanes[1]->rangeExtent.x)[c],
+                                         (&lanes[2]->rangeExtent.x)[c], (&lanes[3]->rangeExtent.x)[c]);
+            __m128 from = _mm_add_ps(mins, _mm_mul_ps(extents, _mm_mul_ps(LoadKeyComponents(keyValues.data(), batch.keys, c), scale)));
+            __m128 to = _mm_add_ps(mins, _mm_mul_ps(extents, _mm_mul_ps(LoadKeyComponents(keyValues.data(), batch.nextKeys, c), scale)));
+            _mm_storeu_ps(decoded[c], _mm_add_ps(from, _mm_mul_ps(alpha, _mm_sub_ps(to, from))));
+        }
+        for (int lane = 0; lane < decodeLanes; lane++)
+        {
+            batch.outputs[lane][0] = decoded[0][lane];
+            batch.outputs[lane][1] = decoded[1][lane];
+            batch.outputs[lane][2] = decoded[2][lane];
+        }
+        batch.count = 0;
+        return;
+    }
+#endif
+    for (int lane = 0; lane < batch.count; lane++)
+    {
+        Vector3 value = DecodeVector(*batch.channels[lane], batch.keys[lane]);
+        if (batch.alphas[lane] > 0.0f)
+        {
+            value = Vector3Lerp(value, DecodeVector(*batch.channels[lane], batch.nextKeys[lane]), batch.alphas[lane]);
+        }
+        batch.outputs[lane][0] = value.x;
+        batch.outputs[lane][1] = value.y;
+        batch.outputs[lane][2] = value.z;
+    }
+    batch.count = 0;
+}
+
+void CompressedClip::DecodeRotations(DecodeBatch& batch) const
+{
+#ifdef COMPRESSEDCLIP_SSE2
+    if (batch.count == decodeLanes)
+    {
+        __m128 from[4];
+        __m128 to[4];
+        DecodeRotationLanes(keyValues.data(), batch.keys, from);
+        DecodeRotationLanes(keyValues.data(), batch.nextKeys, to);
+
+        // KeyLerp(): nlerp along the shortest arc, for the lanes that blend.
+        __m128 dot = _mm_add_ps(_mm_add_ps(_mm_mul_ps(from[0], to[0]), _mm_mul_ps(from[1], to[1])),
+                                _mm_add_ps(_mm_mul_ps(from[2], to[2]), _mm_mul_ps(from[3], to[3])));
+        __m128 flip = _mm_and_ps(_mm_cmplt_ps(dot, _mm_setzero_ps()), _mm_set1_ps(-0.0f));
+        __m128 alpha = _mm_loadu_ps(batch.alphas);
+        __m128 blended[4];
+        for (int c = 0; c < 4; c++)
+        {
+            blended[c] = _mm_add_ps(from[c], _mm_mul_ps(alpha, _mm_sub_ps(_mm_xor_ps(to[c], flip), from[c])));
+        }
+        __m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(blended[0], blended[0]), _mm_mul_ps(blended[1], blended[1])),
+                                                          _mm_mul_ps(blended[2], blended[2])), _mm_mul_ps(blended[3], blended[3])));
+        const __m128 one = _mm_set1_ps(1.0f);
+        length = Select(_mm_cmpeq_ps(length, _mm_setzero_ps()), one, length);
+        __m128 inverseLength = _mm_div_ps(one, length);
+        __m128 blends = _mm_cmpgt_ps(alpha, _mm_setzero_ps());
+        for (int c = 0; c < 4; c++)
+        {
+            from[c] = Select(blends, _mm_mul_ps(blended[c], inverseLength), from[c]);
+        }
+
+        // Lanes hold components, transpose so that each row is one rotation.
+        _MM_TRANSPOSE4_PS(from[0], from[1], from[2], from[3]);
+        for (int lane = 0; lane < decodeLanes; lane++)
+        {
+            _mm_storeu_ps(batch.outputs[lane], from[lane]);
+        }
+        batch.count = 0;
+        return;
+    }
+#endif
+    for (int lane = 0; lane < batch.count; lane++)
+    {
+        Quaternion value = DecodeRotation(batch.keys[lane]);
+        if (batch.alphas[lane] > 0.0f)
+        {
+            value = KeyLerp(value, DecodeRotation(batch.nextKeys[lane]), batch.alphas[lane]);
+        }
+        batch.outputs[lane][0] = value.x;
+        batch.outputs[lane][1] = value.y;
+        batch.outputs[lane][2] = value.z;
+        batch.outputs[lane][3] = value.w;
+    }
+    batch.count = 0;
+}
+
+Vector3 CompressedClip::DecodeVector(const Channel& channel, uint32_t key) const
+{
+    const uint16_t* values = &keyValues[key*3];
+    const float scale = 1.0f/65535.0f;
+    return {
+        channel.rangeMin.x + channel.rangeExtent.x*(values[0]*scale),
+        channel.rangeMin.y + channel.rangeExtent.y*(values[1]*scale),
+        channel.rangeMin.z + channel.rangeExtent.z*(values[2]*scale)
+    };
+}
+
+Quaternion CompressedClip::DecodeRotation(uint32_t key) const
+{
+    const uint16_t* values = &keyValues[key*3];
+    int largest = ((values[0] >> 15) << 1) | (values[1] >> 15);
+    const float scale = 2.0f*smallestThreeRange/32767.0f;
+    float small[3] = {
+        (values[0] & 0x7FFF)*scale - smallestThreeRange,
+        (values[1] & 0x7FFF)*scale - smallestThreeRange,
+        (values[2] & 0x7FFF)*scale - smallestThreeRange
+    };
+    float components[4];
+    int slot = 0;
+    for (int i = 0; i < 4; i++)
+    {
+        if (i != largest) components[i] = small[slot++];
+    }
+    components[largest] = sqrtf(std::max(0.0f, 1.0f - small[0]*small[0] - small[1]*small[1] - small[2]*small[2]));
+    return { components[0], components[1], components[2], components[3] };
+}
+
+}
@@ -0,0 +1,140 @@
+/*******************************************************************************************
+*
+*   CompressedClip.h
+*   Definition of a CompressedClip. A compact copy of an AnimationClip, built with
+*   per-channel error tolerances:
+*     - channels that stay within tolerance of one value keep a single key,
+*     - keys that linear interpolation of their neighbours reproduces within tolerance are
+*       dropped,
+*     - positions and scales are quantized to 16 bits per component over the range each
+*       channel spans,
+*     - rotations store their three smallest components in 15 bits each, plus the index of
+*       the largest one, which is rebuilt from unit length,
+*     - key times are quantized to 16 bits of the clip's duration.
+*   Key reduction is given what is left of the tolerance after the worst quantization error
+*   of the channel's values and of its key times, which shift a channel by at most its
+*   fastest change over half a time step, so decoded values stay within tolerance of the
+*   source keys. Tolerances
+*   are local to each channel; CompressToWorldError() tightens them per track until the
+*   world space joint positions meet a bound.
+*   Every key is three 16 bit values and a 16 bit time. Sampling seeks each channel with a
+*   cursor like the ClipSampler, then decodes the keys found four channels at a time with
+*   SSE2 where available, straight into a Pose.
+*
+*   LICENSE: GPLv3
+*
+*   Copyright (c) 2021 Juniper Dusk (@juniper-dusk)
+*
+*******************************************************************************************/
+
+#ifndef COMPRESSEDCLIP_H
+#define COMPRESSEDCLIP_H
+
+#include "raylib.h"
+#include "AnimationClip.h"
+#include "Pose.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace GameEngine
+{
+
+// Largest error allowed by key reduction, per channel type.
+typedef struct CompressionTolerance
+{
+    float position;     // World units
+    float rotation;     // Radians
+    float scale;        // Scale units
+} CompressionTolerance;
+
+class CompressedClip
+{
+public:
+    // INITIALIZATION.
+    CompressedClip(const AnimationClip& clip, CompressionTolerance tolerance = { 0.001f, 0.001f, 0.001f });
+    // Compress with tolerances halved on the tracks that miss maxWorldError, and on their
+    // parents, until every world space joint position is within it. Starts from tolerance
+    // and gives up after maxRounds, since quantization alone may exceed a very small bound.
+    static CompressedClip CompressToWorldError(const AnimationClip& clip, const Pose& basePose, const int* parents,
+                                               float maxWorldError, float sampleRate,
+                                               CompressionTolerance tolerance = { 0.001f, 0.001f, 0.001f });
+    static const int maxRounds = 12;
+
+    // SAMPLING.
+    // Decode every track at time, clamped to the clip, into the pose. Cursors hold three
+    // entries per track and can start at zero; keep them between calls for fast forward
+    // playback.
+    void Sample(float time, Pose& pose, std::vector<int>& cursors) const;
+    void Sample(float time, PoseBuffer pose, std::vector<int>& cursors) const;
+
+    // QUERIES.
+    float GetDuration() const;
+    int GetTrackCount() const;
+    size_t GetKeyCount() const;
+    // Bytes of key and channel data.
+    size_t GetMemorySize() const;
+    // Bytes of key data in an uncompressed clip.
+    static size_t GetMemorySize(const AnimationClip& clip);
+
+    // ERROR MEASUREMENT.
+    // Largest distance between the world space joint positions of the source clip and of
+    // this one, sampled sampleRate times per second and at every key time of either clip,
+    // where the error of each channel peaks. Poses start from basePose; parents
+    // gives each track's parent track or -1, parents first.
+    float MeasureWorldError(const AnimationClip& clip, const Pose& basePose, const int* parents, float sampleRate) const;
+
+protected:
+    typedef struct Channel
+    {
+        uint32_t firstKey;
+        uint32_t keyCount;
+        // Quantization range, unused by rotations.
+        Vector3 rangeMin;
+        Vector3 rangeExtent;
+    } Channel;
+
+    float duration;
+    int trackCount;
+    // Position, rotation and scale channel of every track.
+    std::vector<Channel> channels;
+    std::vector<uint16_t> keyTimes;
+    // Three values per key.
+    std::vector<uint16_t> keyValues;
+
+    // One tolerance per track.
+    CompressedClip(const AnimationClip& clip, const std::vector<CompressionTolerance>& trackTolerances);
+    void AddVectorChannel(const KeyChannel<Vector3>& source, float tolerance);
+    void AddRotationChannel(const KeyChannel<Quaternion>& source, float tolerance);
+    void AddKeyTime(float time);
+    // Largest world space position error of every track.
+    void MeasureTrackErrors(const AnimationClip& clip, const Pose& basePose, const int* parents, float sampleRate,
+                            std::vector<float>& trackErrors) const;
+    int SeekChannel(const Channel& channel, float time, int& cursor, float& alpha) const;
+
+    // Keys of up to decodeLanes channels, sought and waiting to be decoded together.
+    static const int decodeLanes = 4;
+    typedef struct DecodeBatch
+    {
+        int count;
+        const Channel* channels[decodeLanes];
+        uint32_t keys[decodeLanes];
+        // Key blended towards, the same key when alpha is zero.
+        uint32_t nextKeys[decodeLanes];
+        float alphas[decodeLanes];
+        // First component of the Vector3 or Quaternion written.
+        float* outputs[decodeLanes];
+    } DecodeBatch;
+    // Seek a channel and add its keys to a batch.
+    void QueueKey(DecodeBatch& batch, const Channel& channel, float time, int& cursor, float* output) const;
+    // Decode and write every key in a batch and empty it. Full batches are decoded with
+    // SIMD where available, the rest one by one.
+    void DecodeVectors(DecodeBatch& batch) const;
+    void DecodeRotations(DecodeBatch& batch) const;
+    Vector3 DecodeVector(const Channel& channel, uint32_t key) const;
+    Quaternion DecodeRotation(uint32_t key) const;
+};
+
+}
+
+#endif // COMPRESSEDCLIP_H
@@ -0,0 +1,235 @@
+/*******************************************************************************************
+*
+*   CpuSkinning.cpp
+*   Implementation of a CpuSkinner.
+*
+*   LICENSE: GPLv3
+*
+*   Copyright (c) 2021 Juniper Dusk (@juniper-dusk)
+*
+*******************************************************************************************/
+
+#include "CpuSkinning.h"
+#include <algorithm>
+#include <cmath>
+
+// The AVX2 path is compiled per function, so the library still runs on older CPUs.
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+    #define SKINNING_AVX2
+    #include <immintrin.h>
+#endif
+
+namespace GameEngine
+{
+
+static void SkinRangeScalar(const SkinningSource& source, const Matrix* palette, float* positions, float* normals, int first, int last)
+{
+    for (int v = first; v < last; v++)
+    {
+        // Rows of the blended matrix, in raylib's memory order: m0 m4 m8 m12, m1 ...
+        float rows[12] = { 0.0f };
+        for (int k = 0; k < 4; k++)
+        {
+            float weight = source.boneWeights[v*4 + k];
+            if (weight == 0.0f) continue;
+            const float* bone = (const float*)&palette[source.boneIds[v*4 + k]];
+            for (int i = 0; i < 12; i++)
+            {
+                rows[i] += weight*bone[i];
+            }
+        }
+
+        if (positions)
+        {
+            const float* p = &source.positions[v*3];
+            for (int r = 0; r < 3; r++)
+            {
+                positions[v*3 + r] = rows[r*4]*p[0] + rows[r*4 + 1]*p[1] + rows[r*4 + 2]*p[2] + rows[r*4 + 3];
+            }
+        }
+        if (normals && source.normals)
+        {
+            const float* n = &source.normals[v*3];
+            float skinned[3];
+            for (int r = 0; r < 3; r++)
+            {
+                skinned[r] = rows[r*4]*n[0] + rows[r*4 + 1]*n[1] + rows[r*4 + 2]*n[2];
+            }
+            float length = sqrtf(skinned[0]*skinned[0] + skinned[1]*skinned[1] + skinned[2]*skinned[2]);
+            float scale = (length > 0.0f)? 1.0f/length : 0.0f;
+            for (int r = 0; r < 3; r++)
+            {
+                normals[v*3 + r] = skinned[r]*scale;
+            }
+        }
+    }
+}
+
+#ifdef SKINNING_AVX2
+__attribute__((target("avx2,fma")))
+static void SkinRangeAvx2(const SkinningSource& source, const Matrix* palette, float* positions, float* normals, int first, int last)
+{
+    for (int v = first; v < last; v++)
+    {
+        // Rows 0-1 and rows 2-3 of the blend, eight floats each.
+        __m256 rows01 = _mm256_setzero_ps();
+        __m256 rows23 = _mm256_setzero_ps();
+        for (int k = 0; k < 4; k++)
+        {
+            // Same as the scalar path, unused influences never touch the palette.
+            if (source.boneWeights[v*4 + k] == 0.0f) continue;
+            const float* bone = (const float*)&palette[source.boneIds[v*4 + k]];
+            __m256 weight = _mm256_set1_ps(source.boneWeights[v*4 + k]);
+            rows01 = _mm256_fmadd_ps(weight, _mm256_loadu_ps(bone), rows01);
+            rows23 = _mm256_fmadd_ps(weight, _mm256_loadu_ps(bone + 8), rows23);
+        }
+
+        // Dot every row with (x, y, z, w): two horizontal adds leave x' and z' in the low
+        // lane and y' in the high lane.
+        if (positions)
+        {
+            const float* p = &source.positions[v*3];
+            __m256 point = _mm256_setr_ps(p[0], p[1], p[2], 1.0f, p[0], p[1], p[2], 1.0f);
+            __m256 sums = _mm256_hadd_ps(_mm256_mul_ps(rows01, point), _mm256_mul_ps(rows23, point));
+            sums = _mm256_hadd_ps(sums, sums);
+            positions[v*3] = _mm256_cvtss_f32(sums);
+            positions[v*3 + 1] = _mm_cvtss_f32(_mm256_extractf128_ps(sums, 1));
+            positions[v*3 + 2] = _mm_cvtss_f32(_mm_shuffle_ps(_mm256_castps256_ps128(sums), _mm256_castps256_ps128(sums), 1));
+        }
+        if (normals && source.normals)
+        {
+            const float* n = &source.normals[v*3];
+            __m256 normal = _mm256_setr_ps(n[0], n[1], n[2], 0.0f, n[0], n[1], n[2], 0.0f);
+            __m256 sums = _mm256_hadd_ps(_mm256_mul_ps(rows01, normal), _mm256_mul_ps(rows23, normal));
+            sums = _mm256_hadd_ps(sums, sums);
+            float x = _mm256_cvtss_f32(sums);
+            float y = _mm_cvtss_f32(_mm256_extractf128_ps(sums, 1));
+            float z = _mm_cvtss_f32(_mm_shuffle_ps(_mm256_castps256_ps128(sums), _mm256_castps256_ps128(sums), 1));
+            float length = sqrtf(x*x + y*y + z*z);
+            float scale = (length > 0.0f)? 1.0f/length : 0.0f;
+            normals[v*3] = x*scale;
+            normals[v*3 + 1] = y*scale;
+            normals[v*3 + 2] = z*scale;
+        }
+    }
+}
+#endif
+
+CpuSkinner::CpuSkinner(int threadCount) :
+    threadCount(threadCount),
+    job({ nullptr, nullptr, nullptr, nullptr, 0, 0 }),
+    nextChunk(0),
+    jobGeneration(0),
+    busyWorkers(0),
+    stopping(false)
+{
+    if (this->threadCount <= 0)
+    {
+        this->threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+    for (int i = 1; i < this->threadCount; i++)
+    {
+        workers.emplace_back(&CpuSkinner::WorkerLoop, this);
+    }
+}
+
+CpuSkinner::~CpuSkinner()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread& worker: workers)
+    {
+        worker.join();
+    }
+}
+
+void CpuSkinner::Skin(const SkinningSource& source, const Matrix* palette, float* positions, float* normals)
+{
+    int chunkCount = std::min(threadCount, std::max(1, source.vertexCount/minChunkVertices));
+    if (chunkCount <= 1)
+    {
+        SkinRange(source, palette, positions, normals, 0, source.vertexCount);
+        return;
+    }
+
+    // One contiguous chunk per thread, the calling thread skins chunks too.
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        job = { &source, palette, positions, normals, (source.vertexCount + chunkCount - 1)/chunkCount, chunkCount };
+        nextChunk = 0;
+        busyWorkers = (int)workers.size();
+        jobGeneration++;
+    }
+    wake.notify_all();
+    RunChunks();
+
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [this]() { return busyWorkers == 0; });
+}
+
+void CpuSkinner::SkinMesh(Mesh& mesh, const Matrix* palette)
+{
+    if (!mesh.vertices || !mesh.boneIds || !mesh.boneWeights || !mesh.animVertices) return;
+
+    SkinningSource source = { mesh.vertices, mesh.normals, mesh.boneIds, mesh.boneWeights, mesh.vertexCount };
+    Skin(source, palette, mesh.animVertices, mesh.animNormals);
+}
+
+void CpuSkinner::SkinRange(const SkinningSource& source, const Matrix* palette, float* positions, float* normals, int first, int last)
+{
+#ifdef SKINNING_AVX2
+    if (UsesAvx2())
+    {
+        SkinRangeAvx2(source, palette, positions, normals, first, last);
+        return;
+    }
+#endif
+    SkinRangeScalar(source, palette, positions, normals, first, last);
+}
+
+void CpuSkinner::WorkerLoop()
+{
+    unsigned int seenGeneration = 0;
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true)
+    {
+        wake.wait(lock, [&]() { return stopping || (jobGeneration != seenGeneration); });
+        if (stopping) return;
+        seenGeneration = jobGeneration;
+
+        lock.unlock();
+        RunChunks();
+        lock.lock();
+        if (--busyWorkers == 0) done.notify_one();
+    }
+}
+
+void CpuSkinner::RunChunks()
+{
+    for (int chunk = nextChunk++; chunk < job.chunkCount; chunk = nextChunk++)
+    {
+        int first = chunk*job.chunkSize;
+        int last = std::min(job.source->vertexCount, first + job.chunkSize);
+        SkinRange(*job.source, job.palette, job.positions, job.normals, first, last);
+    }
+}
+
+int CpuSkinner::GetThreadCount() const
+{
+    return threadCount;
+}
+
+bool CpuSkinner::UsesAvx2()
+{
+#ifdef SKINNING_AVX2
+    static const bool supported = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    return supported;
+#else
+    return false;
+#endif
+}
+
+}
@@ -0,0 +1,102 @@
+/*******************************************************************************************
+*
+*   CpuSkinning.h
+*   Definition of a CpuSkinner. Linear blend skinning on the CPU, for collision shapes and
+*   other geometry needed without a GPU. Every vertex blends the palette matrices of its
+*   four bone influences and transforms its position and normal by the blend. Influences
+*   with zero weight are skipped, so their bone ids need not be valid. Vertices are split
+*   into chunks skinned by workers the skinner starts once and keeps, and on x86 CPUs with
+*   AVX2 each vertex blends two matrix rows per instruction, with a scalar path everywhere
+*   else.
+*
+*   LICENSE: GPLv3
+*
+*   Copyright (c) 2021 Juniper Dusk (@juniper-dusk)
+*
+*******************************************************************************************/
+
+#ifndef CPUSKINNING_H
+#define CPUSKINNING_H
+
+#include "raylib.h"
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace GameEngine
+{
+
+// Bind pose vertices with four influences each. Normals and outputs may be NULL.
+typedef struct SkinningSource
+{
+    const float* positions;     // 3 per vertex
+    const float* normals;       // 3 per vertex
+    const int* boneIds;         // 4 per vertex, indices into the palette
+    const float* boneWeights;   // 4 per vertex, summing to one
+    int vertexCount;
+} SkinningSource;
+
+class CpuSkinner
+{
+public:
+    // Smallest chunk handed to a worker thread, smaller meshes skin on the calling thread.
+    static const int minChunkVertices = 8192;
+
+    // INITIALIZATION.
+    // Zero threads uses every hardware thread. The calling thread counts as one, the rest
+    // are started here and wait for work until the skinner is destroyed.
+    CpuSkinner(int threadCount = 0);
+    // Disallow copies.
+    CpuSkinner(const CpuSkinner& copy) = delete;
+    virtual ~CpuSkinner();
+
+    // SKINNING.
+    // Skin every vertex of source with a palette of inverse bind times world matrices.
+    // One call at a time per skinner.
+    void Skin(const SkinningSource& source, const Matrix* palette, float* positions, float* normals);
+    // Skin a mesh with bone data into its animVertices and animNormals.
+    void SkinMesh(Mesh& mesh, const Matrix* palette);
+    // Skin a range of vertices on the calling thread.
+    static void SkinRange(const SkinningSource& source, const Matrix* palette, float* positions, float* normals, int first, int last);
+
+    // QUERIES.
+    int GetThreadCount() const;
+    // True when this CPU runs the AVX2 path.
+    static bool UsesAvx2();
+
+protected:
+    int threadCount;
+
+    // Job of the current Skin() call, split into chunks taken by the workers and caller.
+    typedef struct SkinningJob
+    {
+        const SkinningSource* source;
+        const Matrix* palette;
+        float* positions;
+        float* normals;
+        int chunkSize;
+        int chunkCount;
+    } SkinningJob;
+
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    SkinningJob job;
+    std::atomic<int> nextChunk;
+    // Bumped per job, so a worker knows when there is new work.
+    unsigned int jobGeneration;
+    // Workers not yet done with the current job.
+    int busyWorkers;
+    bool stopping;
+
+    void WorkerLoop();
+    // Skin chunks of the current job until none are left.
+    void RunChunks();
+};
+
+}
+
+#endif // CPUSKINNING_H
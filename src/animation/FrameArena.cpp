@@ -0,0 +1,74 @@
+/*******************************************************************************************
+*
+*   FrameArena.cpp
+*   Implementation of a FrameArena.
+*
+*   LICENSE: GPLv3
+*
+*   Copyright (c) 2021 Juniper Dusk (@juniper-dusk)
+*
+*******************************************************************************************/
+
+#include "FrameArena.h"
+#include <cstdint>
+
+namespace GameEngine
+{
+
+FrameArena::FrameArena(size_t capacity) :
+    block(new unsigned char[capacity]),
+    capacity(capacity),
+    used(0),
+    overflowSize(0)
+{
+}
+
+void* FrameArena::Allocate(size_t size, size_t alignment)
+{
+    uintptr_t base = (uintptr_t)block.get();
+    size_t start = ((base + used + alignment - 1) & ~(uintptr_t)(alignment - 1)) - base;
+    if (start + size <= capacity)
+    {
+        used = start + size;
+        return block.get() + start;
+    }
+    // Out of room this frame, new[] memory is aligned for any fundamental type.
+    overflow.emplace_back(new unsigned char[size]);
+    overflowSize += size + alignment;
+    return overflow.back().get();
+}
+
+PoseBuffer FrameArena::AllocatePose(int count)
+{
+    return {
+        Allocate<Vector3>(count),
+        Allocate<Quaternion>(count),
+        Allocate<Vector3>(count),
+        count
+    };
+}
+
+void FrameArena::Reset()
+{
+    if (!overflow.empty())
+    {
+        // Grow to last frame's total, so the next frame fits in one block.
+        capacity = used + overflowSize;
+        block.reset(new unsigned char[capacity]);
+        overflow.clear();
+        overflowSize = 0;
+    }
+    used = 0;
+}
+
+size_t FrameArena::GetCapacity() const
+{
+    return capacity;
+}
+
+size_t FrameArena::GetUsed() const
+{
+    return used + overflowSize;
+}
+
+}
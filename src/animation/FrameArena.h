@@ -0,0 +1,61 @@
+/*******************************************************************************************
+*
+*   FrameArena.h
+*   Definition of a FrameArena. Bump allocator for memory that lives for one frame, such
+*   as the intermediate poses of a blend. Allocation moves an offset; Reset() frees
+*   everything at once. Requests past the block are served from overflow blocks, and the
+*   next Reset() grows the block to cover them, so steady state frames never allocate.
+*
+*   LICENSE: GPLv3
+*
+*   Copyright (c) 2021 Juniper Dusk (@juniper-dusk)
+*
+*******************************************************************************************/
+
+#ifndef FRAMEARENA_H
+#define FRAMEARENA_H
+
+#include "Pose.h"
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace GameEngine
+{
+
+class FrameArena
+{
+public:
+    // INITIALIZATION.
+    FrameArena(size_t capacity = 256*1024);
+    // Disallow copies.
+    FrameArena(const FrameArena& copy) = delete;
+
+    // ALLOCATION.
+    // Uninitialized memory, valid until the next Reset(). Alignment is at most 16.
+    void* Allocate(size_t size, size_t alignment = 16);
+    template <typename T>
+    T* Allocate(size_t count)
+    {
+        return (T*)Allocate(count*sizeof(T), alignof(T) > 16? 16 : alignof(T));
+    }
+    // Uninitialized pose of count transforms.
+    PoseBuffer AllocatePose(int count);
+    // Free every allocation.
+    void Reset();
+
+    // QUERIES.
+    size_t GetCapacity() const;
+    size_t GetUsed() const;
+
+protected:
+    std::unique_ptr<unsigned char[]> block;
+    size_t capacity;
+    size_t used;
+    std::vector<std::unique_ptr<unsigned char[]>> overflow;
+    size_t overflowSize;
+};
+
+}
+
+#endif // FRAMEARENA_H
@@ -0,0 +1,261 @@
+/*******************************************************************************************
+*
+*   IkSolver.cpp
+*   Implementation of an IkSolver.
+*
+*   LICENSE: GPLv3
+*
+*   Copyright (c) 2021 Juniper Dusk (@juniper-dusk)
+*
+*******************************************************************************************/
+
+#include "IkSolver.h"
+#include "raymath.h"
+#include <algorithm>
+#include <cmath>
+
+namespace GameEngine
+{
+
+const float IK_EPSILON = 0.000001f;
+
+static Quaternion WorldRotation(Matrix world)
+{
+    return QuaternionFromMatrix(GameTransform::ExtractRotation(world));
+}
+
+// Shortest arc between two directions, identity when either is degenerate.
+static Quaternion RotationBetween(Vector3 from, Vector3 to)
+{
+    float fromLength = Vector3Length(from);
+    float toLength = Vector3Length(to);
+    if ((fromLength < IK_EPSILON) || (toLength < IK_EPSILON)) return QuaternionIdentity();
+    from = Vector3Scale(from, 1.0f/fromLength);
+    to = Vector3Scale(to, 1.0f/toLength);
+    if (Vector3DotProduct(from, to) < -1.0f + IK_EPSILON)
+    {
+        // Opposite directions, half a turn about any perpendicular axis.
+        Vector3 axis = Vector3Perpendicular(from);
+        return QuaternionFromAxisAngle(Vector3Normalize(axis), PI);
+    }
+    return QuaternionFromVector3ToVector3(from, to);
+}
+
+IkSolver::IkSolver(int maxIterations, float tolerance) :
+    maxIterations(maxIterations),
+    tolerance(tolerance),
+    rootParentRotation(QuaternionIdentity())
+{
+}
+
+bool IkSolver::BuildChain(GameTransform* root, GameTransform* tip, IkChain& chain)
+{
+    chain.joints.clear();
+    for (GameTransform* joint = tip; joint; joint = joint->GetParent())
+    {
+        chain.joints.push_back(joint);
+        if (joint == root)
+        {
+            std::reverse(chain.joints.begin(), chain.joints.end());
+            return true;
+        }
+    }
+    chain.joints.clear();
+    return false;
+}
+
+int IkSolver::GetMaxIterations() const
+{
+    return maxIterations;
+}
+
+void IkSolver::SetMaxIterations(int maxIterations)
+{
+    this->maxIterations = maxIterations;
+}
+
+float IkSolver::GetTolerance() const
+{
+    return tolerance;
+}
+
+void IkSolver::SetTolerance(float tolerance)
+{
+    this->tolerance = tolerance;
+}
+
+bool IkSolver::SolveCcd(const IkChain& chain, Vector3 target)
+{
+    int count = (int)chain.joints.size();
+    if (count < 2) return false;
+    Gather(chain);
+
+    for (int iteration = 0; (iteration < maxIterations) && !Reached(target); iteration++)
+    {
+        // From the joint nearest the end effector back to the root.
+        for (int joint = count - 2; joint >= 0; joint--)
+        {
+            Vector3 pivot = positions[joint];
+            Quaternion turn = RotationBetween(
+                Vector3Subtract(positions[count - 1], pivot), Vector3Subtract(target, pivot));
+            for (int child = joint + 1; child < count; child++)
+            {
+                positions[child] = Vector3Add(pivot,
+                    Vector3RotateByQuaternion(Vector3Subtract(positions[child], pivot), turn));
+            }
+        }
+    }
+    WriteBack(chain);
+    return Reached(target);
+}
+
+bool IkSolver::SolveFabrik(const IkChain& chain, Vector3 target)
+{
+    int count = (int)chain.joints.size();
+    if (count < 2) return false;
+    Gather(chain);
+
+    Vector3 root = positions[0];
+    float reach = 0.0f;
+    for (float length: lengths)
+    {
+        reach += length;
+    }
+
+    if (Vector3Distance(root, target) >= reach)
+    {
+        // Out of reach, straighten the chain towards the target.
+        Vector3 direction = Vector3Normalize(Vector3Subtract(target, root));
+        for (int joint = 1; joint < count; joint++)
+        {
+            positions[joint] = Vector3Add(positions[joint - 1], Vector3Scale(direction, lengths[joint - 1]));
+        }
+    }
+    else
+    {
+        for (int iteration = 0; (iteration < maxIterations) && !Reached(target); iteration++)
+        {
+            // Backward: pin the end effector on the target and pull the chain after it.
+            positions[count - 1] = target;
+            for (int joint = count - 2; joint >= 0; joint--)
+            {
+                Vector3 direction = Vector3Normalize(Vector3Subtract(positions[joint], positions[joint + 1]));
+                positions[joint] = Vector3Add(positions[joint + 1], Vector3Scale(direction, lengths[joint]));
+            }
+            // Forward: pin the root back in place.
+            positions[0] = root;
+            for (int joint = 1; joint < count; joint++)
+            {
+                Vector3 direction = Vector3Normalize(Vector3Subtract(positions[joint], positions[joint - 1]));
+                positions[joint] = Vector3Add(positions[joint - 1], Vector3Scale(direction, lengths[joint - 1]));
+            }
+        }
+    }
+    WriteBack(chain);
+    return Reached(target);
+}
+
+bool IkSolver::SolveTwoBone(const IkChain& chain, Vector3 target, Vector3 pole)
+{
+    if (chain.joints.size() != 3) return false;
+    Gather(chain);
+
+    Vector3 root = positions[0];
+    float upper = lengths[0];
+    float lower = lengths[1];
+    Vector3 toTarget = Vector3Subtract(target, root);
+    float distance = Vector3Length(toTarget);
+    if (distance < IK_EPSILON) return false;
+    Vector3 direction = Vector3Scale(toTarget, 1.0f/distance);
+    // Keep the triangle valid: no further than full reach, no closer than the bones fold.
+    distance = Clamp(distance, fabsf(upper - lower) + IK_EPSILON, upper + lower - IK_EPSILON);
+
+    // Bend towards the pole, or keep the current bend when the pole is on the target line.
+    Vector3 bend = Vector3Subtract(pole, root);
+    bend = Vector3Subtract(bend, Vector3Scale(direction, Vector3DotProduct(bend, direction)));
+    if (Vector3Length(bend) < IK_EPSILON)
+    {
+        bend = Vector3Subtract(positions[1], root);
+        bend = Vector3Subtract(bend, Vector3Scale(direction, Vector3DotProduct(bend, direction)));
+    }
+    bend = Vector3Normalize(bend);
+
+    // Law of cosines for the angle at the root.
+    float cosine = (upper*upper + distance*distance - lower*lower)/(2.0f*upper*distance);
+    float sine = sqrtf(std::max(0.0f, 1.0f - cosine*cosine));
+    positions[1] = Vector3Add(root, Vector3Add(
+        Vector3Scale(direction, upper*cosine), Vector3Scale(bend, upper*sine)));
+    positions[2] = Vector3Add(root, Vector3Scale(direction, distance));
+
+    WriteBack(chain);
+    return Reached(target);
+}
+
+bool IkSolver::Solve(const IkGoal& goal)
+{
+    switch (goal.method)
+    {
+        case IK_CCD: return SolveCcd(*goal.chain, goal.target);
+        case IK_FABRIK: return SolveFabrik(*goal.chain, goal.target);
+        case IK_TWO_BONE: return SolveTwoBone(*goal.chain, goal.target, goal.pole);
+        default: return false;
+    }
+}
+
+int IkSolver::SolveBatch(const IkGoal* goals, int count)
+{
+    int reached = 0;
+    for (int i = 0; i < count; i++)
+    {
+        if (Solve(goals[i])) reached++;
+    }
+    return reached;
+}
+
+void IkSolver::Gather(const IkChain& chain)
+{
+    int count = (int)chain.joints.size();
+    positions.resize(count);
+    rotations.resize(count);
+    lengths.resize(count - 1);
+
+    // One cached world matrix per joint; the first read rebuilds what is dirty.
+    for (int joint = 0; joint < count; joint++)
+    {
+        Matrix world = chain.joints[joint]->GetLocalToWorldMatrix();
+        positions[joint] = GameTransform::ExtractTranslation(world);
+        rotations[joint] = WorldRotation(world);
+        if (joint > 0) lengths[joint - 1] = Vector3Distance(positions[joint - 1], positions[joint]);
+    }
+    startPositions.assign(positions.begin(), positions.end());
+
+    const GameTransform* parent = chain.joints[0]->GetParent();
+    rootParentRotation = parent? WorldRotation(parent->GetLocalToWorldMatrix()) : QuaternionIdentity();
+}
+
+void IkSolver::WriteBack(const IkChain& chain)
+{
+    int count = (int)chain.joints.size();
+    // Rotation applied to every joint so far, which carries the bones below along.
+    Quaternion carried = QuaternionIdentity();
+    Quaternion parentRotation = rootParentRotation;
+    for (int joint = 0; joint < count - 1; joint++)
+    {
+        Vector3 bone = Vector3RotateByQuaternion(Vector3Subtract(startPositions[joint + 1], startPositions[joint]), carried);
+        Quaternion turn = RotationBetween(bone, Vector3Subtract(positions[joint + 1], positions[joint]));
+        carried = QuaternionNormalize(QuaternionMultiply(turn, carried));
+        Quaternion world = QuaternionMultiply(carried, rotations[joint]);
+
+        Quaternion local = QuaternionMultiply(QuaternionInvert(parentRotation), world);
+        chain.joints[joint]->SetLocalQuaternion(QuaternionNormalize(local));
+        parentRotation = world;
+    }
+    // The end effector keeps its local rotation and so follows its parent.
+}
+
+bool IkSolver::Reached(Vector3 target) const
+{
+    return Vector3Distance(positions.back(), target) <= tolerance;
+}
+
+}
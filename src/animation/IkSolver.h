@@ -0,0 +1,101 @@
+/*******************************************************************************************
+*
+*   IkSolver.h
+*   Definition of an IkSolver. CCD, FABRIK and analytic two bone inverse kinematics over
+*   chains of transforms. A solve reads each joint's cached world matrix once into a local
+*   buffer, iterates on that buffer only, and writes back nothing but the final local
+*   rotations, so no iteration walks the hierarchy.
+*
+*   Solvers move joints and keep bone lengths; joint rotations are the shortest arcs that
+*   point each bone at its solved child, so twist along a bone is left as it was.
+*
+*   LICENSE: GPLv3
+*
+*   Copyright (c) 2021 Juniper Dusk (@juniper-dusk)
+*
+*******************************************************************************************/
+
+#ifndef IKSOLVER_H
+#define IKSOLVER_H
+
+#include "raylib.h"
+#include <transform/GameTransform.h>
+#include <vector>
+
+namespace GameEngine
+{
+
+typedef enum IkMethod
+{
+    IK_CCD = 0,
+    IK_FABRIK,
+    // Three joints only: root, middle and end effector.
+    IK_TWO_BONE
+} IkMethod;
+
+// Joints from the chain root to the end effector, each the parent of the next.
+typedef struct IkChain
+{
+    std::vector<GameTransform*> joints;
+} IkChain;
+
+// One chain to solve in a batch.
+typedef struct IkGoal
+{
+    IkChain* chain;
+    IkMethod method;
+    Vector3 target;
+    // World point the middle joint bends towards, for two bone chains.
+    Vector3 pole;
+} IkGoal;
+
+class IkSolver
+{
+public:
+    // INITIALIZATION.
+    IkSolver(int maxIterations = 10, float tolerance = 0.001f);
+    // Disallow copies.
+    IkSolver(const IkSolver& copy) = delete;
+
+    // Fill chain with tip and its ancestors up to root. Returns false if root is not an
+    // ancestor of tip.
+    static bool BuildChain(GameTransform* root, GameTransform* tip, IkChain& chain);
+
+    // ITERATION PROPERTIES.
+    int GetMaxIterations() const;
+    void SetMaxIterations(int maxIterations);
+    // Distance from the target at which iterative solvers stop.
+    float GetTolerance() const;
+    void SetTolerance(float tolerance);
+
+    // SOLVING.
+    // Each returns true when the end effector ends within tolerance of the target.
+    bool SolveCcd(const IkChain& chain, Vector3 target);
+    bool SolveFabrik(const IkChain& chain, Vector3 target);
+    bool SolveTwoBone(const IkChain& chain, Vector3 target, Vector3 pole);
+    bool Solve(const IkGoal& goal);
+    // Solve goals in order, reusing the same buffers. Chains sharing joints see the
+    // rotations written by earlier goals. Returns the number of goals reached.
+    int SolveBatch(const IkGoal* goals, int count);
+
+protected:
+    int maxIterations;
+    float tolerance;
+
+    // World space buffer of the chain being solved.
+    std::vector<Vector3> positions;
+    std::vector<Vector3> startPositions;
+    std::vector<Quaternion> rotations;
+    std::vector<float> lengths;
+    Quaternion rootParentRotation;
+
+    // Read world positions, rotations and bone lengths of a chain into the buffer.
+    void Gather(const IkChain& chain);
+    // Turn moved positions into local rotations and write them to the chain.
+    void WriteBack(const IkChain& chain);
+    bool Reached(Vector3 target) const;
+};
+
+}
+
+#endif // IKSOLVER_H
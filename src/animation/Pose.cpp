@@ -0,0 +1,64 @@
+/*******************************************************************************************
+*
+*   Pose.cpp
+*   Implementation of a Pose.
+*
+*   LICENSE: GPLv3
+*
+*   Copyright (c) 2021 Juniper Dusk (@juniper-dusk)
+*
+*******************************************************************************************/
+
+#include "Pose.h"
+#include <algorithm>
+
+namespace GameEngine
+{
+
+Pose::Pose()
+{
+}
+
+Pose::Pose(int count)
+{
+    Resize(count);
+}
+
+void Pose::Resize(int count)
+{
+    positions.resize(count, { 0.0f, 0.0f, 0.0f });
+    rotations.resize(count, { 0.0f, 0.0f, 0.0f, 1.0f });
+    scales.resize(count, { 1.0f, 1.0f, 1.0f });
+}
+
+int Pose::GetCount() const
+{
+    return (int)positions.size();
+}
+
+PoseBuffer Pose::GetBuffer()
+{
+    return { positions.data(), rotations.data(), scales.data(), GetCount() };
+}
+
+void Pose::CaptureFrom(GameTransform* const* transforms, int count)
+{
+    Resize(std::max(count, GetCount()));
+    for (int i = 0; i < count; i++)
+    {
+        positions[i] = transforms[i]->GetLocalPosition();
+        rotations[i] = transforms[i]->GetLocalQuaternion();
+        scales[i] = transforms[i]->GetLocalScale();
+    }
+}
+
+void Pose::ApplyTo(GameTransform* const* transforms, int count) const
+{
+    count = std::min(count, GetCount());
+    for (int i = 0; i < count; i++)
+    {
+        transforms[i]->SetLocalPose(positions[i], rotations[i], scales[i]);
+    }
+}
+
+}
@@ -0,0 +1,61 @@
+/*******************************************************************************************
+*
+*   Pose.h
+*   Definition of a Pose. Local position, rotation and scale of a set of transforms, one
+*   contiguous array per channel, as written by animation sampling and blending. A final
+*   pose goes straight into a skinning palette with Skeleton::ComputePalette(), or is
+*   copied onto GameTransforms in one pass when gameplay code needs them. PoseBuffer is the
+*   same layout over memory owned elsewhere, such as a FrameArena.
+*
+*   LICENSE: GPLv3
+*
+*   Copyright (c) 2021 Juniper Dusk (@juniper-dusk)
+*
+*******************************************************************************************/
+
+#ifndef POSE_H
+#define POSE_H
+
+#include "raylib.h"
+#include <transform/GameTransform.h>
+#include <vector>
+
+namespace GameEngine
+{
+
+// Pose channels in storage owned by someone else.
+typedef struct PoseBuffer
+{
+    Vector3* positions;
+    Quaternion* rotations;
+    Vector3* scales;
+    int count;
+} PoseBuffer;
+
+class Pose
+{
+public:
+    std::vector<Vector3> positions;
+    std::vector<Quaternion> rotations;
+    std::vector<Vector3> scales;
+
+    // INITIALIZATION.
+    Pose();
+    // Count transforms at rest: no translation or rotation, unit scale.
+    Pose(int count);
+
+    void Resize(int count);
+    int GetCount() const;
+    // View of this pose's storage, valid until it is resized.
+    PoseBuffer GetBuffer();
+
+    // TRANSFORMS.
+    // Read the local pose of count transforms.
+    void CaptureFrom(GameTransform* const* transforms, int count);
+    // Write the pose into count transforms, marking each dirty once.
+    void ApplyTo(GameTransform* const* transforms, int count) const;
+};
+
+}
+
+#endif // POSE_H
@@ -0,0 +1,198 @@
+/*******************************************************************************************
+*
+*   PoseBlend.cpp
+*   Implementation of the pose blending operations.
+*
+*   LICENSE: GPLv3
+*
+*   Copyright (c) 2021 Juniper Dusk (@juniper-dusk)
+*
+*******************************************************************************************/
+
+#include "PoseBlend.h"
+#include "raymath.h"
+#include <cmath>
+#include <cstring>
+
+namespace GameEngine
+{
+
+static Quaternion NormalizeRotation(float x, float y, float z, float w)
+{
+    float length = sqrtf(x*x + y*y + z*z + w*w);
+    if (length == 0.0f) return { 0.0f, 0.0f, 0.0f, 1.0f };
+    float inverse = 1.0f/length;
+    return { x*inverse, y*inverse, z*inverse, w*inverse };
+}
+
+static Quaternion BlendRotation(Quaternion from, Quaternion to, float alpha, bool slerp)
+{
+    float dot = from.x*to.x + from.y*to.y + from.z*to.z + from.w*to.w;
+    // Shortest arc, either sign of a quaternion is the same rotation.
+    float sign = (dot < 0.0f)? -1.0f : 1.0f;
+    dot *= sign;
+    float fromWeight = 1.0f - alpha;
+    float toWeight = alpha*sign;
+    // Nearly parallel rotations slerp no better than nlerp, and divide by almost zero.
+    if (slerp && (dot < 0.9995f))
+    {
+        float angle = acosf(dot);
+        float inverseSin = 1.0f/sinf(angle);
+        fromWeight = sinf((1.0f - alpha)*angle)*inverseSin;
+        toWeight = sinf(alpha*angle)*inverseSin*sign;
+        return {
+            from.x*fromWeight + to.x*toWeight,
+            from.y*fromWeight + to.y*toWeight,
+            from.z*fromWeight + to.z*toWeight,
+            from.w*fromWeight + to.w*toWeight
+        };
+    }
+    return NormalizeRotation(
+        from.x*fromWeight + to.x*toWeight,
+        from.y*fromWeight + to.y*toWeight,
+        from.z*fromWeight + to.z*toWeight,
+        from.w*fromWeight + to.w*toWeight
+    );
+}
+
+void CopyPose(PoseBuffer from, PoseBuffer to)
+{
+    if (from.positions == to.positions) return;
+    memcpy(to.positions, from.positions, from.count*sizeof(Vector3));
+    memcpy(to.rotations, from.rotations, from.count*sizeof(Quaternion));
+    memcpy(to.scales, from.scales, from.count*sizeof(Vector3));
+}
+
+void BlendPoses(const PoseBuffer* inputs, const float* weights, int count, PoseBuffer output)
+{
+    float total = 0.0f;
+    for (int input = 0; input < count; input++)
+    {
+        total += weights[input];
+    }
+    if ((count == 0) || (total <= 0.0f)) return;
+
+    int boneCount = output.count;
+    float first = weights[0]/total;
+    // Start from the first input, so the output may alias it.
+    const float* source = &inputs[0].positions[0].x;
+    float* positions = &output.positions[0].x;
+    float* scales = &output.scales[0].x;
+    for (int i = 0; i < boneCount*3; i++)
+    {
+        positions[i] = source[i]*first;
+    }
+    source = &inputs[0].scales[0].x;
+    for (int i = 0; i < boneCount*3; i++)
+    {
+        scales[i] = source[i]*first;
+    }
+    for (int bone = 0; bone < boneCount; bone++)
+    {
+        Quaternion rotation = inputs[0].rotations[bone];
+        output.rotations[bone] = { rotation.x*first, rotation.y*first, rotation.z*first, rotation.w*first };
+    }
+
+    for (int input = 1; input < count; input++)
+    {
+        float weight = weights[input]/total;
+        if (weight == 0.0f) continue;
+        source = &inputs[input].positions[0].x;
+        for (int i = 0; i < boneCount*3; i++)
+        {
+            positions[i] += source[i]*weight;
+        }
+        source = &inputs[input].scales[0].x;
+        for (int i = 0; i < boneCount*3; i++)
+        {
+            scales[i] += source[i]*weight;
+        }
+        for (int bone = 0; bone < boneCount; bone++)
+        {
+            // Accumulate on the same hemisphere as the sum so far.
+            Quaternion sum = output.rotations[bone];
+            Quaternion rotation = inputs[input].rotations[bone];
+            float dot = sum.x*rotation.x + sum.y*rotation.y + sum.z*rotation.z + sum.w*rotation.w;
+            float signedWeight = (dot < 0.0f)? -weight : weight;
+            output.rotations[bone] = {
+                sum.x + rotation.x*signedWeight,
+                sum.y + rotation.y*signedWeight,
+                sum.z + rotation.z*signedWeight,
+                sum.w + rotation.w*signedWeight
+            };
+        }
+    }
+
+    for (int bone = 0; bone < boneCount; bone++)
+    {
+        Quaternion sum = output.rotations[bone];
+        output.rotations[bone] = NormalizeRotation(sum.x, sum.y, sum.z, sum.w);
+    }
+}
+
+void LerpPoses(PoseBuffer a, PoseBuffer b, float alpha, const float* mask, bool slerp, PoseBuffer output)
+{
+    int boneCount = output.count;
+    if (!mask)
+    {
+        // Same factor everywhere, blend the vector channels as flat arrays.
+        const float* from = &a.positions[0].x;
+        const float* to = &b.positions[0].x;
+        float* result = &output.positions[0].x;
+        for (int i = 0; i < boneCount*3; i++)
+        {
+            result[i] = from[i] + (to[i] - from[i])*alpha;
+        }
+        from = &a.scales[0].x;
+        to = &b.scales[0].x;
+        result = &output.scales[0].x;
+        for (int i = 0; i < boneCount*3; i++)
+        {
+            result[i] = from[i] + (to[i] - from[i])*alpha;
+        }
+        for (int bone = 0; bone < boneCount; bone++)
+        {
+            output.rotations[bone] = BlendRotation(a.rotations[bone], b.rotations[bone], alpha, slerp);
+        }
+        return;
+    }
+
+    for (int bone = 0; bone < boneCount; bone++)
+    {
+        float boneAlpha = alpha*mask[bone];
+        output.positions[bone] = Vector3Lerp(a.positions[bone], b.positions[bone], boneAlpha);
+        output.scales[bone] = Vector3Lerp(a.scales[bone], b.scales[bone], boneAlpha);
+        output.rotations[bone] = BlendRotation(a.rotations[bone], b.rotations[bone], boneAlpha, slerp);
+    }
+}
+
+void AddPoses(PoseBuffer base, PoseBuffer additive, PoseBuffer reference, float weight, const float* mask, PoseBuffer output)
+{
+    const Quaternion identity = { 0.0f, 0.0f, 0.0f, 1.0f };
+    int boneCount = output.count;
+    for (int bone = 0; bone < boneCount; bone++)
+    {
+        float boneWeight = mask? weight*mask[bone] : weight;
+
+        Vector3 offset = Vector3Subtract(additive.positions[bone], reference.positions[bone]);
+        output.positions[bone] = Vector3Add(base.positions[bone], Vector3Scale(offset, boneWeight));
+
+        // Scale layers multiply; a zero reference scale has no defined ratio.
+        Vector3 referenceScale = reference.scales[bone];
+        Vector3 additiveScale = additive.scales[bone];
+        Vector3 ratio = {
+            (referenceScale.x != 0.0f)? additiveScale.x/referenceScale.x : 1.0f,
+            (referenceScale.y != 0.0f)? additiveScale.y/referenceScale.y : 1.0f,
+            (referenceScale.z != 0.0f)? additiveScale.z/referenceScale.z : 1.0f
+        };
+        ratio = Vector3Lerp({ 1.0f, 1.0f, 1.0f }, ratio, boneWeight);
+        output.scales[bone] = Vector3Multiply(base.scales[bone], ratio);
+
+        // Delta such that additive = reference * delta, applied after base the same way.
+        Quaternion delta = QuaternionMultiply(QuaternionInvert(reference.rotations[bone]), additive.rotations[bone]);
+        delta = BlendRotation(identity, delta, boneWeight, false);
+        output.rotations[bone] = QuaternionNormalize(QuaternionMultiply(base.rotations[bone], delta));
+    }
+}
+
+}
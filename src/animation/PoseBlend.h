@@ -0,0 +1,35 @@
+/*******************************************************************************************
+*
+*   PoseBlend.h
+*   Batch operations over whole poses: copy, N-way weighted blend, two-way blend with an
+*   optional per bone mask, and additive layering. Each runs as a few flat loops over the
+*   pose channels. Rotations blend by normalized lerp along the shortest arc, or by slerp
+*   when asked. Outputs may alias the first pose passed in.
+*
+*   LICENSE: GPLv3
+*
+*   Copyright (c) 2021 Juniper Dusk (@juniper-dusk)
+*
+*******************************************************************************************/
+
+#ifndef POSEBLEND_H
+#define POSEBLEND_H
+
+#include "raylib.h"
+#include "Pose.h"
+
+namespace GameEngine
+{
+
+void CopyPose(PoseBuffer from, PoseBuffer to);
+// Weighted average of count poses. Weights are normalized by their sum.
+void BlendPoses(const PoseBuffer* inputs, const float* weights, int count, PoseBuffer output);
+// Move from a towards b by alpha, times mask[bone] when a mask is given.
+void LerpPoses(PoseBuffer a, PoseBuffer b, float alpha, const float* mask, bool slerp, PoseBuffer output);
+// Layer the difference of additive from reference onto base, by weight times mask[bone]
+// when a mask is given.
+void AddPoses(PoseBuffer base, PoseBuffer additive, PoseBuffer reference, float weight, const float* mask, PoseBuffer output);
+
+}
+
+#endif // POSEBLEND_H
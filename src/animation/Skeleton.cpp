@@ -0,0 +1,120 @@
+/*******************************************************************************************
+*
+*   Skeleton.cpp
+*   Implementation of a Skeleton.
+*
+*   LICENSE: GPLv3
+*
+*   Copyright (c) 2021 Juniper Dusk (@juniper-dusk)
+*
+*******************************************************************************************/
+
+#include "Skeleton.h"
+#include "raymath.h"
+
+namespace GameEngine
+{
+
+Skeleton::Skeleton()
+{
+}
+
+int Skeleton::AddBone(GameTransform* transform, Matrix inverseBind)
+{
+    auto found = indices.find(transform);
+    if (found != indices.end()) return found->second;
+
+    // Bones whose parent is not a bone are roots, placed by their cached world matrix.
+    int parent = FindBone(transform->GetParent());
+    int index = (int)bones.size();
+    indices[transform] = index;
+    bones.push_back(transform);
+    parents.push_back(parent);
+    inverseBinds.push_back(inverseBind);
+    worldMatrices.push_back(MatrixIdentity());
+    return index;
+}
+
+void Skeleton::Bind(GameTransform* root)
+{
+    // Depth first, so every parent is added before its children.
+    std::vector<GameTransform*> stack = { root };
+    while (!stack.empty())
+    {
+        GameTransform* node = stack.back();
+        stack.pop_back();
+        AddBone(node, node->GetWorldToLocalMatrix());
+        // Reversed, so children keep their order in the bone array.
+        const std::list<GameTransform*>& children = node->GetChildren();
+        for (auto child = children.rbegin(); child != children.rend(); child++)
+        {
+            stack.push_back(*child);
+        }
+    }
+}
+
+void Skeleton::Clear()
+{
+    bones.clear();
+    parents.clear();
+    inverseBinds.clear();
+    indices.clear();
+    worldMatrices.clear();
+}
+
+int Skeleton::GetBoneCount() const
+{
+    return (int)bones.size();
+}
+
+GameTransform* Skeleton::GetBone(int index) const
+{
+    return bones.at(index);
+}
+
+int Skeleton::GetParent(int index) const
+{
+    return parents.at(index);
+}
+
+const Matrix& Skeleton::GetInverseBind(int index) const
+{
+    return inverseBinds.at(index);
+}
+
+int Skeleton::FindBone(const GameTransform* transform) const
+{
+    auto found = indices.find(transform);
+    return (found != indices.end())? found->second : -1;
+}
+
+void Skeleton::ComputePalette(Matrix* palette)
+{
+    for (size_t i = 0; i < bones.size(); i++)
+    {
+        int parent = parents[i];
+        if (parent < 0) worldMatrices[i] = bones[i]->GetLocalToWorldMatrix();
+        else worldMatrices[i] = MatrixMultiply(bones[i]->GetLocalMatrix(), worldMatrices[parent]);
+        palette[i] = MatrixMultiply(inverseBinds[i], worldMatrices[i]);
+    }
+}
+
+void Skeleton::ComputePalette(const Pose& pose, Matrix* palette)
+{
+    for (size_t i = 0; i < bones.size(); i++)
+    {
+        Matrix local = GameTransform::ComposeMatrix(pose.positions[i], pose.rotations[i], pose.scales[i]);
+        int parent = parents[i];
+        if (parent >= 0) worldMatrices[i] = MatrixMultiply(local, worldMatrices[parent]);
+        else if (bones[i]->GetParent()) worldMatrices[i] = MatrixMultiply(local, bones[i]->GetParent()->GetLocalToWorldMatrix());
+        else worldMatrices[i] = local;
+        palette[i] = MatrixMultiply(inverseBinds[i], worldMatrices[i]);
+    }
+}
+
+const std::vector<Matrix>& Skeleton::GetWorldMatrices() const
+{
+    return worldMatrices;
+}
+
+}
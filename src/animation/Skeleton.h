@@ -0,0 +1,71 @@
+/*******************************************************************************************
+*
+*   Skeleton.h
+*   Definition of a Skeleton. Binds an ordered array of bones, each driven by a
+*   GameTransform, with the inverse bind matrix of every bone. Bones are stored parents
+*   before children, so the skinning palette (inverse bind, then world) is built in one
+*   linear pass: each bone's world matrix is its local matrix times its parent's, already
+*   computed earlier in the same pass.
+*
+*   LICENSE: GPLv3
+*
+*   Copyright (c) 2021 Juniper Dusk (@juniper-dusk)
+*
+*******************************************************************************************/
+
+#ifndef SKELETON_H
+#define SKELETON_H
+
+#include "raylib.h"
+#include "Pose.h"
+#include <transform/GameTransform.h>
+#include <unordered_map>
+#include <vector>
+
+namespace GameEngine
+{
+
+class Skeleton
+{
+public:
+    // INITIALIZATION.
+    Skeleton();
+    // Disallow copies.
+    Skeleton(const Skeleton& copy) = delete;
+
+    // BONES.
+    // Add a bone after its parent bone, if it has one. Returns the bone's index.
+    int AddBone(GameTransform* transform, Matrix inverseBind);
+    // Add root and all of its descendants as bones, bound in their current pose.
+    void Bind(GameTransform* root);
+    void Clear();
+    int GetBoneCount() const;
+    GameTransform* GetBone(int index) const;
+    // Index of the parent bone, or -1 for a root bone.
+    int GetParent(int index) const;
+    const Matrix& GetInverseBind(int index) const;
+    // Index of the bone driven by a transform, or -1.
+    int FindBone(const GameTransform* transform) const;
+
+    // PALETTE.
+    // Write every bone's inverse bind times world matrix into palette, which must hold
+    // GetBoneCount() matrices.
+    void ComputePalette(Matrix* palette);
+    // Same, with the local pose of every bone read from pose, one entry per bone in bone
+    // order. Sampled poses go to the palette without being written into the bones'
+    // transforms; root bones still follow the world matrix of their transform's parent.
+    void ComputePalette(const Pose& pose, Matrix* palette);
+    // World matrices of the last ComputePalette(), in bone order.
+    const std::vector<Matrix>& GetWorldMatrices() const;
+
+protected:
+    std::vector<GameTransform*> bones;
+    std::vector<int> parents;
+    std::vector<Matrix> inverseBinds;
+    std::unordered_map<const GameTransform*, int> indices;
+    std::vector<Matrix> worldMatrices;
+};
+
+}
+
+#endif // SKELETON_H
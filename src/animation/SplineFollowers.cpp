@@ -0,0 +1,134 @@
+/*******************************************************************************************
+*
+*   SplineFollowers.cpp
+*   Implementation of SplineFollowers.
+*
+*   LICENSE: GPLv3
+*
+*   Copyright (c) 2021 Juniper Dusk (@juniper-dusk)
+*
+*******************************************************************************************/
+
+#include "SplineFollowers.h"
+#include "raymath.h"
+#include <cmath>
+
+namespace GameEngine
+{
+
+SplineFollowers::SplineFollowers()
+{
+}
+
+int SplineFollowers::Add(GameTransform* transform, const SplinePath* path, float speed, float distance, SplineWrap wrap, bool alignRotation)
+{
+    transforms.push_back(transform);
+    paths.push_back(path);
+    distances.push_back(distance);
+    speeds.push_back(speed);
+    cursors.push_back(0);
+    wraps.push_back((uint8_t)wrap);
+    aligned.push_back(alignRotation? 1 : 0);
+    return (int)transforms.size() - 1;
+}
+
+void SplineFollowers::Remove(int index)
+{
+    int last = (int)transforms.size() - 1;
+    if ((index < 0) || (index > last)) return;
+    transforms[index] = transforms[last];
+    paths[index] = paths[last];
+    distances[index] = distances[last];
+    speeds[index] = speeds[last];
+    cursors[index] = cursors[last];
+    wraps[index] = wraps[last];
+    aligned[index] = aligned[last];
+    transforms.pop_back();
+    paths.pop_back();
+    distances.pop_back();
+    speeds.pop_back();
+    cursors.pop_back();
+    wraps.pop_back();
+    aligned.pop_back();
+}
+
+void SplineFollowers::Clear()
+{
+    transforms.clear();
+    paths.clear();
+    distances.clear();
+    speeds.clear();
+    cursors.clear();
+    wraps.clear();
+    aligned.clear();
+}
+
+int SplineFollowers::GetCount() const
+{
+    return (int)transforms.size();
+}
+
+float SplineFollowers::GetDistance(int index) const
+{
+    return distances.at(index);
+}
+
+void SplineFollowers::SetDistance(int index, float distance)
+{
+    distances.at(index) = distance;
+}
+
+float SplineFollowers::GetSpeed(int index) const
+{
+    return speeds.at(index);
+}
+
+void SplineFollowers::SetSpeed(int index, float speed)
+{
+    speeds.at(index) = speed;
+}
+
+void SplineFollowers::Update(float deltaTime)
+{
+    int count = (int)transforms.size();
+    for (int i = 0; i < count; i++)
+    {
+        const SplinePath* path = paths[i];
+        float length = path->GetLength();
+        if (length <= 0.0f) continue;
+        float distance = distances[i] + speeds[i]*deltaTime;
+
+        switch (wraps[i])
+        {
+            case SPLINE_LOOP:
+                if ((distance < 0.0f) || (distance >= length)) distance -= floorf(distance/length)*length;
+                break;
+            case SPLINE_PING_PONG:
+                // Reflect off whichever end was passed and head back.
+                if ((distance < 0.0f) || (distance > length))
+                {
+                    distance = (distance < 0.0f)? -distance : 2.0f*length - distance;
+                    distance = Clamp(distance, 0.0f, length);
+                    speeds[i] = -speeds[i];
+                }
+                break;
+            default:
+                distance = Clamp(distance, 0.0f, length);
+                break;
+        }
+        distances[i] = distance;
+
+        Vector3 position;
+        Vector3 tangent;
+        path->Evaluate(path->GetParameter(distance, cursors[i]), position, tangent);
+        transforms[i]->SetLocalPosition(position);
+        if (aligned[i] && (Vector3Length(tangent) > 0.000001f))
+        {
+            // Face the way the follower moves, also when heading back along the path.
+            if (speeds[i] < 0.0f) tangent = Vector3Negate(tangent);
+            transforms[i]->SetLocalQuaternion(GameTransform::LookRotation(tangent, { 0.0f, 1.0f, 0.0f }));
+        }
+    }
+}
+
+}
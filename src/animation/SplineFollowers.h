@@ -0,0 +1,78 @@
+/*******************************************************************************************
+*
+*   SplineFollowers.h
+*   Definition of SplineFollowers. Transforms moving along spline paths at a speed in
+*   distance per second, kept in flat arrays and advanced in one pass. Each follower keeps
+*   its own arc-length table cursor, so a frame costs a constant number of table steps per
+*   follower, and its position and travel-aligned rotation are written straight to the
+*   transform's local position and rotation. Paths are in the followers' parent space.
+*
+*   LICENSE: GPLv3
+*
+*   Copyright (c) 2021 Juniper Dusk (@juniper-dusk)
+*
+*******************************************************************************************/
+
+#ifndef SPLINEFOLLOWERS_H
+#define SPLINEFOLLOWERS_H
+
+#include "raylib.h"
+#include "SplinePath.h"
+#include <transform/GameTransform.h>
+#include <cstdint>
+#include <vector>
+
+namespace GameEngine
+{
+
+typedef enum SplineWrap
+{
+    // Stop at the ends.
+    SPLINE_CLAMP = 0,
+    // Jump back to the start, for closed paths.
+    SPLINE_LOOP,
+    // Turn around at the ends.
+    SPLINE_PING_PONG
+} SplineWrap;
+
+class SplineFollowers
+{
+public:
+    // INITIALIZATION.
+    SplineFollowers();
+    // Disallow copies.
+    SplineFollowers(const SplineFollowers& copy) = delete;
+
+    // FOLLOWERS.
+    // Returns the follower's index. Paths and transforms must outlive their followers.
+    int Add(GameTransform* transform, const SplinePath* path, float speed,
+        float distance = 0.0f, SplineWrap wrap = SPLINE_LOOP, bool alignRotation = true);
+    // Moves the last follower into index.
+    void Remove(int index);
+    void Clear();
+    int GetCount() const;
+
+    // FOLLOWER PROPERTIES.
+    float GetDistance(int index) const;
+    void SetDistance(int index, float distance);
+    float GetSpeed(int index) const;
+    void SetSpeed(int index, float speed);
+
+    // UPDATE.
+    // Move every follower and write its local position, and rotation when aligned. The
+    // rotation turns +Z along the direction of travel, with +Y towards the parent's up.
+    void Update(float deltaTime);
+
+protected:
+    std::vector<GameTransform*> transforms;
+    std::vector<const SplinePath*> paths;
+    std::vector<float> distances;
+    std::vector<float> speeds;
+    std::vector<int> cursors;
+    std::vector<uint8_t> wraps;
+    std::vector<uint8_t> aligned;
+};
+
+}
+
+#endif // SPLINEFOLLOWERS_H
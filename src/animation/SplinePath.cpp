@@ -0,0 +1,194 @@
+/*******************************************************************************************
+*
+*   SplinePath.cpp
+*   Implementation of a SplinePath.
+*
+*   LICENSE: GPLv3
+*
+*   Copyright (c) 2021 Juniper Dusk (@juniper-dusk)
+*
+*******************************************************************************************/
+
+#include "SplinePath.h"
+#include "raymath.h"
+#include <algorithm>
+#include <cmath>
+
+namespace GameEngine
+{
+
+// Lookups further than this from their cursor binary search instead of stepping.
+const int maxCursorSteps = 8;
+
+SplinePath::SplinePath(SplineType type, const std::vector<Vector3>& points, bool closed, int samplesPerSegment) :
+    type(type),
+    closed(closed && (type == SPLINE_CATMULL_ROM)),
+    samplesPerSegment(std::max(1, samplesPerSegment))
+{
+    if (type == SPLINE_BEZIER) BuildBezier(points);
+    else BuildCatmullRom(points);
+    BuildLengths();
+}
+
+SplineType SplinePath::GetType() const
+{
+    return type;
+}
+
+bool SplinePath::IsClosed() const
+{
+    return closed;
+}
+
+int SplinePath::GetSegmentCount() const
+{
+    return (int)segments.size();
+}
+
+float SplinePath::GetLength() const
+{
+    return lengths.empty()? 0.0f : lengths.back();
+}
+
+Vector3 SplinePath::GetPosition(float parameter) const
+{
+    Vector3 position = { 0.0f, 0.0f, 0.0f };
+    Vector3 tangent = { 0.0f, 0.0f, 0.0f };
+    Evaluate(parameter, position, tangent);
+    return position;
+}
+
+Vector3 SplinePath::GetTangent(float parameter) const
+{
+    Vector3 position = { 0.0f, 0.0f, 0.0f };
+    Vector3 tangent = { 0.0f, 0.0f, 0.0f };
+    Evaluate(parameter, position, tangent);
+    return tangent;
+}
+
+void SplinePath::Evaluate(float parameter, Vector3& position, Vector3& tangent) const
+{
+    if (segments.empty()) return;
+    float t = 0.0f;
+    const SplineSegment& segment = Locate(parameter, t);
+    position = Vector3Add(Vector3Scale(Vector3Add(Vector3Scale(Vector3Add(
+        Vector3Scale(segment.a, t), segment.b), t), segment.c), t), segment.d);
+    tangent = Vector3Add(Vector3Scale(Vector3Add(
+        Vector3Scale(segment.a, 3.0f*t), Vector3Scale(segment.b, 2.0f)), t), segment.c);
+}
+
+float SplinePath::GetParameter(float distance, int& cursor) const
+{
+    int last = (int)lengths.size() - 1;
+    if (last <= 0) return 0.0f;
+    if (distance <= 0.0f)
+    {
+        cursor = 0;
+        return 0.0f;
+    }
+    if (distance >= lengths[last])
+    {
+        cursor = last - 1;
+        return (float)segments.size();
+    }
+
+    // Step from the cursor while the entry is close, search the table when it is not.
+    int index = std::min(std::max(cursor, 0), last - 1);
+    int steps = 0;
+    while ((steps < maxCursorSteps) && (distance >= lengths[index + 1]) && (index < last - 1))
+    {
+        index++;
+        steps++;
+    }
+    while ((steps < maxCursorSteps) && (distance < lengths[index]) && (index > 0))
+    {
+        index--;
+        steps++;
+    }
+    if ((distance < lengths[index]) || (distance >= lengths[index + 1]))
+    {
+        index = (int)(std::upper_bound(lengths.begin(), lengths.end(), distance) - lengths.begin()) - 1;
+        index = std::min(std::max(index, 0), last - 1);
+    }
+    cursor = index;
+
+    float span = lengths[index + 1] - lengths[index];
+    float fraction = (span > 0.0f)? (distance - lengths[index])/span : 0.0f;
+    return (index + fraction)/samplesPerSegment;
+}
+
+float SplinePath::GetParameter(float distance) const
+{
+    int cursor = 0;
+    return GetParameter(distance, cursor);
+}
+
+void SplinePath::BuildCatmullRom(const std::vector<Vector3>& points)
+{
+    int count = (int)points.size();
+    if (count < 2) return;
+    // Open ends get a mirrored neighbour so the curve still starts and ends on them.
+    auto point = [&](int index) {
+        if (closed) return points[(index + count) % count];
+        if (index < 0) return Vector3Subtract(Vector3Scale(points[0], 2.0f), points[1]);
+        if (index >= count) return Vector3Subtract(Vector3Scale(points[count - 1], 2.0f), points[count - 2]);
+        return points[index];
+    };
+
+    int segmentCount = closed? count : count - 1;
+    segments.resize(segmentCount);
+    for (int i = 0; i < segmentCount; i++)
+    {
+        Vector3 p0 = point(i - 1);
+        Vector3 p1 = point(i);
+        Vector3 p2 = point(i + 1);
+        Vector3 p3 = point(i + 2);
+        segments[i].a = Vector3Scale(Vector3Add(Vector3Subtract(p3, p0), Vector3Scale(Vector3Subtract(p1, p2), 3.0f)), 0.5f);
+        segments[i].b = Vector3Scale(Vector3Subtract(Vector3Add(Vector3Scale(p0, 2.0f), Vector3Scale(p2, 4.0f)),
+            Vector3Add(Vector3Scale(p1, 5.0f), p3)), 0.5f);
+        segments[i].c = Vector3Scale(Vector3Subtract(p2, p0), 0.5f);
+        segments[i].d = p1;
+    }
+}
+
+void SplinePath::BuildBezier(const std::vector<Vector3>& points)
+{
+    int segmentCount = ((int)points.size() - 1)/3;
+    segments.resize(std::max(0, segmentCount));
+    for (int i = 0; i < segmentCount; i++)
+    {
+        Vector3 p0 = points[i*3];
+        Vector3 p1 = points[i*3 + 1];
+        Vector3 p2 = points[i*3 + 2];
+        Vector3 p3 = points[i*3 + 3];
+        segments[i].a = Vector3Add(Vector3Subtract(p3, p0), Vector3Scale(Vector3Subtract(p1, p2), 3.0f));
+        segments[i].b = Vector3Scale(Vector3Add(Vector3Subtract(p0, Vector3Scale(p1, 2.0f)), p2), 3.0f);
+        segments[i].c = Vector3Scale(Vector3Subtract(p1, p0), 3.0f);
+        segments[i].d = p0;
+    }
+}
+
+void SplinePath::BuildLengths()
+{
+    int sampleCount = (int)segments.size()*samplesPerSegment;
+    lengths.assign(sampleCount + 1, 0.0f);
+    if (sampleCount == 0) return;
+
+    Vector3 previous = GetPosition(0.0f);
+    for (int sample = 1; sample <= sampleCount; sample++)
+    {
+        Vector3 position = GetPosition((float)sample/samplesPerSegment);
+        lengths[sample] = lengths[sample - 1] + Vector3Distance(previous, position);
+        previous = position;
+    }
+}
+
+const SplinePath::SplineSegment& SplinePath::Locate(float parameter, float& t) const
+{
+    int last = (int)segments.size() - 1;
+    int index = std::min(std::max((int)floorf(parameter), 0), last);
+    t = Clamp(parameter - index, 0.0f, 1.0f);
+    return segments[index];
+}
+
+}
@@ -0,0 +1,88 @@
+/*******************************************************************************************
+*
+*   SplinePath.h
+*   Definition of a SplinePath. A Catmull-Rom or cubic Bezier curve with its segments kept
+*   as polynomial coefficients and an arc-length lookup table built once. Distance along the
+*   path turns into a curve parameter through the table; a cursor kept by the caller starts
+*   the search where the last lookup ended, so steady motion finds its entry in a step or
+*   two instead of re-integrating arc length.
+*
+*   LICENSE: GPLv3
+*
+*   Copyright (c) 2021 Juniper Dusk (@juniper-dusk)
+*
+*******************************************************************************************/
+
+#ifndef SPLINEPATH_H
+#define SPLINEPATH_H
+
+#include "raylib.h"
+#include <vector>
+
+namespace GameEngine
+{
+
+typedef enum SplineType
+{
+    // Passes through every point.
+    SPLINE_CATMULL_ROM = 0,
+    // Point, two controls, point, two controls, ... point.
+    SPLINE_BEZIER
+} SplineType;
+
+class SplinePath
+{
+public:
+    // INITIALIZATION.
+    // Closed Catmull-Rom paths join the last point back to the first. The lookup table
+    // takes samplesPerSegment lengths per segment.
+    SplinePath(SplineType type, const std::vector<Vector3>& points, bool closed = false, int samplesPerSegment = 32);
+    // Disallow copies.
+    SplinePath(const SplinePath& copy) = delete;
+
+    // QUERIES.
+    SplineType GetType() const;
+    bool IsClosed() const;
+    int GetSegmentCount() const;
+    float GetLength() const;
+
+    // EVALUATION.
+    // Parameter runs from 0 to GetSegmentCount(), one unit per segment.
+    Vector3 GetPosition(float parameter) const;
+    // Derivative along the parameter, not normalized.
+    Vector3 GetTangent(float parameter) const;
+    void Evaluate(float parameter, Vector3& position, Vector3& tangent) const;
+
+    // ARC LENGTH.
+    // Parameter at a distance along the path, clamped to the ends. cursor is a table index
+    // to start from, updated to where this lookup ended; keep one per moving object.
+    float GetParameter(float distance, int& cursor) const;
+    float GetParameter(float distance) const;
+
+protected:
+    typedef struct SplineSegment
+    {
+        // Position is ((a*t + b)*t + c)*t + d over t in [0, 1].
+        Vector3 a;
+        Vector3 b;
+        Vector3 c;
+        Vector3 d;
+    } SplineSegment;
+
+    SplineType type;
+    bool closed;
+    int samplesPerSegment;
+    std::vector<SplineSegment> segments;
+    // Length from the start at every table sample, samplesPerSegment per segment.
+    std::vector<float> lengths;
+
+    void BuildCatmullRom(const std::vector<Vector3>& points);
+    void BuildBezier(const std::vector<Vector3>& points);
+    void BuildLengths();
+    // Segment holding a parameter, and the parameter within it.
+    const SplineSegment& Locate(float parameter, float& t) const;
+};
+
+}
+
+#endif // SPLINEPATH_H
@@ -0,0 +1,261 @@
+/*******************************************************************************************
+*
+*   TweenEngine.cpp
+*   Implementation of a TweenEngine.
+*
+*   LICENSE: GPLv3
+*
+*   Copyright (c) 2021 Juniper Dusk (@juniper-dusk)
+*
+*******************************************************************************************/
+
+#include "TweenEngine.h"
+#include "raymath.h"
+#include <cmath>
+
+namespace GameEngine
+{
+
+// Easing curves over [0, 1], from Robert Penner's equations.
+static inline float EaseLinear(float t) { return t; }
+static inline float EaseQuadIn(float t) { return t*t; }
+static inline float EaseQuadOut(float t) { return t*(2.0f - t); }
+static inline float EaseQuadInOut(float t) { return (t < 0.5f)? 2.0f*t*t : -1.0f + (4.0f - 2.0f*t)*t; }
+static inline float EaseCubicIn(float t) { return t*t*t; }
+static inline float EaseCubicOut(float t) { float u = t - 1.0f; return u*u*u + 1.0f; }
+static inline float EaseCubicInOut(float t) { float u = 2.0f*t - 2.0f; return (t < 0.5f)? 4.0f*t*t*t : 0.5f*u*u*u + 1.0f; }
+static inline float EaseSineInOut(float t) { return 0.5f - 0.5f*cosf(PI*t); }
+static inline float EaseBackOut(float t) { const float s = 1.70158f; float u = t - 1.0f; return u*u*((s + 1.0f)*u + s) + 1.0f; }
+
+TweenEngine::TweenEngine() :
+    activeCount(0)
+{
+}
+
+TweenId TweenEngine::TweenPosition(GameTransform* transform, Vector3 to, float duration, TweenEasing easing)
+{
+    Vector3 from = transform->GetLocalPosition();
+    return Start(transform, TWEEN_POSITION, easing, &from.x, &to.x, duration);
+}
+
+TweenId TweenEngine::TweenRotation(GameTransform* transform, Quaternion to, float duration, TweenEasing easing)
+{
+    Quaternion from = transform->GetLocalQuaternion();
+    // Travel the shortest arc.
+    if (from.x*to.x + from.y*to.y + from.z*to.z + from.w*to.w < 0.0f) to = QuaternionScale(to, -1.0f);
+    return Start(transform, TWEEN_ROTATION, easing, &from.x, &to.x, duration);
+}
+
+TweenId TweenEngine::TweenScale(GameTransform* transform, Vector3 to, float duration, TweenEasing easing)
+{
+    Vector3 from = transform->GetLocalScale();
+    return Start(transform, TWEEN_SCALE, easing, &from.x, &to.x, duration);
+}
+
+bool TweenEngine::Stop(TweenId id)
+{
+    int slot = FindSlot(id);
+    if (slot < 0) return false;
+    Remove(locations[slot].group, locations[slot].index);
+    return true;
+}
+
+int TweenEngine::StopAll(const GameTransform* transform)
+{
+    int stopped = 0;
+    for (int group = 0; group < EASE_COUNT*TWEEN_PROPERTY_COUNT; group++)
+    {
+        std::vector<GameTransform*>& targets = groups[group].targets;
+        for (int i = (int)targets.size() - 1; i >= 0; i--)
+        {
+            if (targets[i] != transform) continue;
+            Remove(group, i);
+            stopped++;
+        }
+    }
+    return stopped;
+}
+
+void TweenEngine::Clear()
+{
+    for (TweenGroup& group: groups)
+    {
+        group = TweenGroup();
+    }
+    // Slots are kept with their generations, so ids from before stay inactive.
+    for (uint32_t slot = 0; slot < (uint32_t)locations.size(); slot++)
+    {
+        if (locations[slot].group < 0) continue;
+        locations[slot].group = -1;
+        locations[slot].generation++;
+        freeSlots.push_back(slot);
+    }
+    activeCount = 0;
+}
+
+int TweenEngine::Advance(float deltaTime)
+{
+    for (int groupIndex = 0; groupIndex < EASE_COUNT*TWEEN_PROPERTY_COUNT; groupIndex++)
+    {
+        if (groups[groupIndex].targets.empty()) continue;
+        switch ((TweenEasing)(groupIndex/TWEEN_PROPERTY_COUNT))
+        {
+            case EASE_QUAD_IN: AdvanceGroup<EaseQuadIn>(groupIndex, deltaTime); break;
+            case EASE_QUAD_OUT: AdvanceGroup<EaseQuadOut>(groupIndex, deltaTime); break;
+            case EASE_QUAD_IN_OUT: AdvanceGroup<EaseQuadInOut>(groupIndex, deltaTime); break;
+            case EASE_CUBIC_IN: AdvanceGroup<EaseCubicIn>(groupIndex, deltaTime); break;
+            case EASE_CUBIC_OUT: AdvanceGroup<EaseCubicOut>(groupIndex, deltaTime); break;
+            case EASE_CUBIC_IN_OUT: AdvanceGroup<EaseCubicInOut>(groupIndex, deltaTime); break;
+            case EASE_SINE_IN_OUT: AdvanceGroup<EaseSineInOut>(groupIndex, deltaTime); break;
+            case EASE_BACK_OUT: AdvanceGroup<EaseBackOut>(groupIndex, deltaTime); break;
+            default: AdvanceGroup<EaseLinear>(groupIndex, deltaTime); break;
+        }
+    }
+    return activeCount;
+}
+
+template <float (*Curve)(float)>
+void TweenEngine::AdvanceGroup(int groupIndex, float deltaTime)
+{
+    TweenGroup& group = groups[groupIndex];
+    TweenProperty property = (TweenProperty)(groupIndex%TWEEN_PROPERTY_COUNT);
+    float* elapsed = group.elapsed.data();
+    const float* inverseDurations = group.inverseDurations.data();
+    const float* fromX = group.from[0].data();
+    const float* fromY = group.from[1].data();
+    const float* fromZ = group.from[2].data();
+    const float* fromW = group.from[3].data();
+    const float* deltaX = group.delta[0].data();
+    const float* deltaY = group.delta[1].data();
+    const float* deltaZ = group.delta[2].data();
+    const float* deltaW = group.delta[3].data();
+    GameTransform* const* targets = group.targets.data();
+
+    // Back to front, so a finished tween is replaced by one that was already advanced.
+    for (int i = (int)group.targets.size() - 1; i >= 0; i--)
+    {
+        elapsed[i] += deltaTime;
+        float progress = elapsed[i]*inverseDurations[i];
+        bool finished = (progress >= 1.0f);
+        float t = Curve(finished? 1.0f : progress);
+
+        Vector3 value = { fromX[i] + deltaX[i]*t, fromY[i] + deltaY[i]*t, fromZ[i] + deltaZ[i]*t };
+        if (property == TWEEN_POSITION) targets[i]->SetLocalPosition(value);
+        else if (property == TWEEN_SCALE) targets[i]->SetLocalScale(value);
+        else
+        {
+            // Normalized lerp, close enough to slerp over the arcs tweens cover.
+            Quaternion rotation = { value.x, value.y, value.z, fromW[i] + deltaW[i]*t };
+            targets[i]->SetLocalQuaternion(QuaternionNormalize(rotation));
+        }
+
+        if (finished) Remove(groupIndex, i);
+    }
+}
+
+bool TweenEngine::IsActive(TweenId id) const
+{
+    return FindSlot(id) >= 0;
+}
+
+int TweenEngine::GetActiveCount() const
+{
+    return activeCount;
+}
+
+float TweenEngine::Ease(TweenEasing easing, float progress)
+{
+    float t = Clamp(progress, 0.0f, 1.0f);
+    switch (easing)
+    {
+        case EASE_QUAD_IN: return EaseQuadIn(t);
+        case EASE_QUAD_OUT: return EaseQuadOut(t);
+        case EASE_QUAD_IN_OUT: return EaseQuadInOut(t);
+        case EASE_CUBIC_IN: return EaseCubicIn(t);
+        case EASE_CUBIC_OUT: return EaseCubicOut(t);
+        case EASE_CUBIC_IN_OUT: return EaseCubicInOut(t);
+        case EASE_SINE_IN_OUT: return EaseSineInOut(t);
+        case EASE_BACK_OUT: return EaseBackOut(t);
+        default: return EaseLinear(t);
+    }
+}
+
+TweenId TweenEngine::Start(GameTransform* transform, TweenProperty property, TweenEasing easing, const float* from, const float* to, float duration)
+{
+    uint32_t slot;
+    if (!freeSlots.empty())
+    {
+        slot = freeSlots.back();
+        freeSlots.pop_back();
+    }
+    else
+    {
+        slot = (uint32_t)locations.size();
+        locations.push_back({ -1, 0, 0 });
+    }
+
+    int groupIndex = (int)easing*TWEEN_PROPERTY_COUNT + (int)property;
+    TweenGroup& group = groups[groupIndex];
+    locations[slot].group = groupIndex;
+    locations[slot].index = (int)group.targets.size();
+    group.targets.push_back(transform);
+    group.slots.push_back(slot);
+    group.elapsed.push_back(0.0f);
+    // A zero duration finishes on the next advance.
+    group.inverseDurations.push_back((duration > 0.0f)? 1.0f/duration : 1e30f);
+    int components = (property == TWEEN_ROTATION)? 4 : 3;
+    for (int c = 0; c < 4; c++)
+    {
+        group.from[c].push_back((c < components)? from[c] : 0.0f);
+        group.delta[c].push_back((c < components)? to[c] - from[c] : 0.0f);
+    }
+    activeCount++;
+    return ((TweenId)locations[slot].generation << 32) | slot;
+}
+
+void TweenEngine::Remove(int groupIndex, int index)
+{
+    TweenGroup& group = groups[groupIndex];
+    int last = (int)group.targets.size() - 1;
+    uint32_t slot = group.slots[index];
+
+    // Swap the last tween into the freed slot.
+    if (index != last)
+    {
+        group.targets[index] = group.targets[last];
+        group.slots[index] = group.slots[last];
+        group.elapsed[index] = group.elapsed[last];
+        group.inverseDurations[index] = group.inverseDurations[last];
+        for (int c = 0; c < 4; c++)
+        {
+            group.from[c][index] = group.from[c][last];
+            group.delta[c][index] = group.delta[c][last];
+        }
+        locations[group.slots[index]].index = index;
+    }
+    group.targets.pop_back();
+    group.slots.pop_back();
+    group.elapsed.pop_back();
+    group.inverseDurations.pop_back();
+    for (int c = 0; c < 4; c++)
+    {
+        group.from[c].pop_back();
+        group.delta[c].pop_back();
+    }
+
+    locations[slot].group = -1;
+    locations[slot].generation++;
+    freeSlots.push_back(slot);
+    activeCount--;
+}
+
+int TweenEngine::FindSlot(TweenId id) const
+{
+    uint32_t slot = (uint32_t)id;
+    if (slot >= locations.size()) return -1;
+    const TweenLocation& location = locations[slot];
+    if ((location.group < 0) || (location.generation != (uint32_t)(id >> 32))) return -1;
+    return (int)slot;
+}
+
+}
@@ -0,0 +1,122 @@
+/*******************************************************************************************
+*
+*   TweenEngine.h
+*   Definition of a TweenEngine. Tweens of local position, rotation and scale, stored in
+*   structure of arrays groups keyed by easing function and property. Advancing runs one
+*   pass per group with its easing curve inlined, so there is no per tween dispatch, that
+*   writes each eased value straight to its transform. Finished tweens are removed in the
+*   same pass by moving the group's last tween into their slot.
+*
+*   Transforms must outlive their tweens, or be stopped first.
+*
+*   LICENSE: GPLv3
+*
+*   Copyright (c) 2021 Juniper Dusk (@juniper-dusk)
+*
+*******************************************************************************************/
+
+#ifndef TWEENENGINE_H
+#define TWEENENGINE_H
+
+#include "raylib.h"
+#include <transform/GameTransform.h>
+#include <cstdint>
+#include <vector>
+
+namespace GameEngine
+{
+
+typedef enum TweenEasing
+{
+    EASE_LINEAR = 0,
+    EASE_QUAD_IN,
+    EASE_QUAD_OUT,
+    EASE_QUAD_IN_OUT,
+    EASE_CUBIC_IN,
+    EASE_CUBIC_OUT,
+    EASE_CUBIC_IN_OUT,
+    EASE_SINE_IN_OUT,
+    EASE_BACK_OUT,
+    EASE_COUNT
+} TweenEasing;
+
+typedef enum TweenProperty
+{
+    TWEEN_POSITION = 0,
+    TWEEN_ROTATION,
+    TWEEN_SCALE,
+    TWEEN_PROPERTY_COUNT
+} TweenProperty;
+
+// Slot in the low 32 bits and the slot's generation in the high 32 bits, so an id kept
+// after its tween finished never matches a later tween that reuses the slot.
+typedef uint64_t TweenId;
+
+class TweenEngine
+{
+public:
+    // INITIALIZATION.
+    TweenEngine();
+    // Disallow copies.
+    TweenEngine(const TweenEngine& copy) = delete;
+
+    // STARTING.
+    // Tween from the transform's current local value to a target over duration seconds.
+    TweenId TweenPosition(GameTransform* transform, Vector3 to, float duration, TweenEasing easing = EASE_LINEAR);
+    TweenId TweenRotation(GameTransform* transform, Quaternion to, float duration, TweenEasing easing = EASE_LINEAR);
+    TweenId TweenScale(GameTransform* transform, Vector3 to, float duration, TweenEasing easing = EASE_LINEAR);
+
+    // STOPPING.
+    // Leave the property where it is. Returns false if the tween already finished.
+    bool Stop(TweenId id);
+    // Stop every tween on a transform.
+    int StopAll(const GameTransform* transform);
+    void Clear();
+
+    // UPDATE.
+    // Advance every tween and write the results. Returns the number still running.
+    int Advance(float deltaTime);
+
+    // QUERIES.
+    bool IsActive(TweenId id) const;
+    int GetActiveCount() const;
+    // Eased value of progress in [0, 1].
+    static float Ease(TweenEasing easing, float progress);
+
+protected:
+    // Tweens sharing an easing and a property. Vectors use the first three components.
+    typedef struct TweenGroup
+    {
+        std::vector<GameTransform*> targets;
+        std::vector<uint32_t> slots;
+        std::vector<float> elapsed;
+        std::vector<float> inverseDurations;
+        std::vector<float> from[4];
+        // Target minus start.
+        std::vector<float> delta[4];
+    } TweenGroup;
+
+    typedef struct TweenLocation
+    {
+        int group;      // -1 when the slot is free
+        int index;
+        uint32_t generation;    // Bumped whenever the slot is freed
+    } TweenLocation;
+
+    TweenGroup groups[EASE_COUNT*TWEEN_PROPERTY_COUNT];
+    std::vector<TweenLocation> locations;
+    std::vector<uint32_t> freeSlots;
+    int activeCount;
+
+    TweenId Start(GameTransform* transform, TweenProperty property, TweenEasing easing, const float* from, const float* to, float duration);
+    void Remove(int group, int index);
+    // Slot of an id still running, -1 otherwise.
+    int FindSlot(TweenId id) const;
+    // Advance, write and compact one group, with its easing curve inlined.
+    template <float (*Curve)(float)>
+    void AdvanceGroup(int group, float deltaTime);
+};
+
+}
+
+#endif // TWEENENGINE_H
@@ -0,0 +1,166 @@
+/*******************************************************************************************
+*
+*   DebugDraw.cpp
+*   Implementation of a DebugDraw buffer.
+*
+*   LICENSE: GPLv3
+*
+*   Copyright (c) 2021 Juniper Dusk (@juniper-dusk)
+*
+*******************************************************************************************/
+
+#include "DebugDraw.h"
+#include "RenderStats.h"
+#include "raymath.h"
+#include "rlgl.h"
+#include <algorithm>
+
+namespace GameEngine
+{
+
+DebugDraw::DebugDraw() :
+    enabled(true)
+{
+}
+
+bool DebugDraw::IsEnabled() const
+{
+    return enabled;
+}
+
+void DebugDraw::SetEnabled(bool enabled)
+{
+    this->enabled = enabled;
+    if (!enabled) vertices.clear();
+}
+
+void DebugDraw::Begin()
+{
+    vertices.clear();
+}
+
+void DebugDraw::Line(Vector3 start, Vector3 end, Color color)
+{
+    if (!enabled) return;
+    vertices.push_back({ start, color });
+    vertices.push_back({ end, color });
+}
+
+void DebugDraw::Axes(Matrix transform, float size)
+{
+    if (!enabled) return;
+    Vector3 origin = GameTransform::ExtractTranslation(transform);
+    // Matrix columns are the transformed basis vectors.
+    Vector3 axisX = Vector3Normalize({ transform.m0, transform.m1, transform.m2 });
+    Vector3 axisY = Vector3Normalize({ transform.m4, transform.m5, transform.m6 });
+    Vector3 axisZ = Vector3Normalize({ transform.m8, transform.m9, transform.m10 });
+    Line(origin, Vector3Add(origin, Vector3Scale(axisX, size)), RED);
+    Line(origin, Vector3Add(origin, Vector3Scale(axisY, size)), GREEN);
+    Line(origin, Vector3Add(origin, Vector3Scale(axisZ, size)), BLUE);
+}
+
+void DebugDraw::Box(BoundingBox box, Color color)
+{
+    Box(box, MatrixIdentity(), color);
+}
+
+void DebugDraw::Box(BoundingBox box, Matrix transform, Color color)
+{
+    if (!enabled) return;
+    // Corner i takes max on the axes whose bit is set.
+    Vector3 corners[8];
+    for (int i = 0; i < 8; i++)
+    {
+        Vector3 corner = {
+            (i & 1)? box.max.x : box.min.x,
+            (i & 2)? box.max.y : box.min.y,
+            (i & 4)? box.max.z : box.min.z
+        };
+        corners[i] = Vector3Transform(corner, transform);
+    }
+    // Edges join corners that differ in exactly one bit.
+    for (int i = 0; i < 8; i++)
+    {
+        for (int bit = 1; bit < 8; bit <<= 1)
+        {
+            if (!(i & bit)) Line(corners[i], corners[i | bit], color);
+        }
+    }
+}
+
+void DebugDraw::Sphere(Vector3 center, float radius, Color color, int segments)
+{
+    if (!enabled || (segments < 3)) return;
+    float step = 2.0f*PI/segments;
+    for (int i = 0; i < segments; i++)
+    {
+        float c0 = cosf(i*step)*radius, s0 = sinf(i*step)*radius;
+        float c1 = cosf((i + 1)*step)*radius, s1 = sinf((i + 1)*step)*radius;
+        // XY, YZ and XZ circles.
+        Line(Vector3Add(center, { c0, s0, 0.0f }), Vector3Add(center, { c1, s1, 0.0f }), color);
+        Line(Vector3Add(center, { 0.0f, c0, s0 }), Vector3Add(center, { 0.0f, c1, s1 }), color);
+        Line(Vector3Add(center, { c0, 0.0f, s0 }), Vector3Add(center, { c1, 0.0f, s1 }), color);
+    }
+}
+
+void DebugDraw::TransformAxes(const GameTransform& transform, float axisSize)
+{
+    if (!enabled) return;
+    Axes(transform.GetLocalToWorldMatrix(), axisSize);
+}
+
+void DebugDraw::Hierarchy(const GameTransform& root, float axisSize, Color linkColor)
+{
+    if (!enabled) return;
+    stack.clear();
+    stack.push_back(&root);
+    while (!stack.empty())
+    {
+        const GameTransform* node = stack.back();
+        stack.pop_back();
+
+        // World matrices are cached, so each node costs one lookup here.
+        Matrix world = node->GetLocalToWorldMatrix();
+        if (axisSize > 0.0f) Axes(world, axisSize);
+        if (node->GetParent() && (node != &root))
+        {
+            Vector3 parentPosition = GameTransform::ExtractTranslation(node->GetParent()->GetLocalToWorldMatrix());
+            Line(parentPosition, GameTransform::ExtractTranslation(world), linkColor);
+        }
+        for (const GameTransform* child: node->GetChildren())
+        {
+            stack.push_back(child);
+        }
+    }
+}
+
+int DebugDraw::Flush()
+{
+    int batches = 0;
+    size_t count = vertices.size();
+    for (size_t first = 0; first < count; first += flushVertexLimit)
+    {
+        int chunk = (int)std::min<size_t>(flushVertexLimit, count - first);
+        // Make room for the whole chunk, drawing the current batch if it is full.
+        rlCheckRenderBatchLimit(chunk);
+        rlBegin(RL_LINES);
+        for (int i = 0; i < chunk; i++)
+        {
+            const DebugVertex& vertex = vertices[first + i];
+            rlColor4ub(vertex.color.r, vertex.color.g, vertex.color.b, vertex.color.a);
+            rlVertex3f(vertex.position.x, vertex.position.y, vertex.position.z);
+        }
+        rlEnd();
+        CountBatchedDraw(chunk);
+        batches++;
+    }
+    vertices.clear();
+    return batches;
+}
+
+size_t DebugDraw::GetLineCount() const
+{
+    return vertices.size()/2;
+}
+
+}
@@ -0,0 +1,79 @@
+/*******************************************************************************************
+*
+*   DebugDraw.h
+*   Definition of a DebugDraw buffer. Lines, axes, boxes and spheres are accumulated in a
+*   CPU side vertex array while the scene is traversed, then flushed to rlgl as a few
+*   large line batches instead of one DrawLine3D call per segment.
+*
+*   Meant to stay compiled in release builds; disabling it makes every call a no-op.
+*
+*   LICENSE: GPLv3
+*
+*   Copyright (c) 2021 Juniper Dusk (@juniper-dusk)
+*
+*******************************************************************************************/
+
+#ifndef DEBUGDRAW_H
+#define DEBUGDRAW_H
+
+#include "raylib.h"
+#include <transform/GameTransform.h>
+#include <cstddef>
+#include <vector>
+
+namespace GameEngine
+{
+
+typedef struct DebugVertex
+{
+    Vector3 position;
+    Color color;
+} DebugVertex;
+
+class DebugDraw
+{
+public:
+    // Vertices handed to rlgl between batch limit checks.
+    static const int flushVertexLimit = 8192;
+
+    // INITIALIZATION.
+    DebugDraw();
+    // Disallow copies.
+    DebugDraw(const DebugDraw& copy) = delete;
+
+    // ENABLED PROPERTY.
+    bool IsEnabled() const;
+    void SetEnabled(bool enabled);
+
+    // ACCUMULATION.
+    // Start a new frame, keeping vertex storage.
+    void Begin();
+    void Line(Vector3 start, Vector3 end, Color color);
+    // X, Y and Z axes of a matrix in red, green and blue.
+    void Axes(Matrix transform, float size);
+    // Axis aligned box.
+    void Box(BoundingBox box, Color color);
+    // Box in the local space of a matrix.
+    void Box(BoundingBox box, Matrix transform, Color color);
+    // Three circles, one around each axis.
+    void Sphere(Vector3 center, float radius, Color color, int segments = 16);
+    // Axes of a single transform.
+    void TransformAxes(const GameTransform& transform, float axisSize);
+    // Parent-child links and local axes of a whole hierarchy, in one depth first walk.
+    void Hierarchy(const GameTransform& root, float axisSize, Color linkColor);
+
+    // SUBMISSION.
+    // Send accumulated lines to rlgl. Returns the number of batches used.
+    int Flush();
+    size_t GetLineCount() const;
+
+protected:
+    bool enabled;
+    std::vector<DebugVertex> vertices;
+    // Traversal stack, kept to avoid allocating per frame.
+    std::vector<const GameTransform*> stack;
+};
+
+}
+
+#endif // DEBUGDRAW_H
@@ -0,0 +1,102 @@
+/*******************************************************************************************
+*
+*   HierarchyRenderer.cpp
+*   Implementation of a HierarchyRenderer.
+*
+*   LICENSE: GPLv3
+*
+*   Copyright (c) 2021 Juniper Dusk (@juniper-dusk)
+*
+*******************************************************************************************/
+
+#include "HierarchyRenderer.h"
+#include "RenderStats.h"
+#include "raymath.h"
+#include "rlgl.h"
+
+namespace GameEngine
+{
+
+HierarchyRenderer::HierarchyRenderer()
+{
+}
+
+void HierarchyRenderer::Attach(const GameTransform* transform, const RenderModel* model)
+{
+    attachments.emplace(transform, model);
+}
+
+void HierarchyRenderer::Detach(const GameTransform* transform)
+{
+    attachments.erase(transform);
+}
+
+void HierarchyRenderer::Clear()
+{
+    attachments.clear();
+}
+
+int HierarchyRenderer::DrawHierarchy(const GameTransform& root)
+{
+    int visited = 0;
+    stack.clear();
+    stack.push_back({ &root, 0, false });
+
+    while (!stack.empty())
+    {
+        TraversalEntry entry = stack.back();
+        stack.pop_back();
+
+        if (entry.exit)
+        {
+            if (entry.depth < maxStackDepth) rlPopMatrix();
+            continue;
+        }
+
+        // The root brings its whole world matrix, every other node only its local one.
+        Matrix local = (entry.node == &root)? root.GetLocalToWorldMatrix() : entry.node->GetLocalMatrix();
+        Matrix relative = MatrixIdentity();
+        if (entry.depth < maxStackDepth)
+        {
+            rlPushMatrix();
+            rlMultMatrixf(MatrixToFloat(local));
+        }
+        else
+        {
+            // Out of rlgl stack, accumulate on the CPU relative to the deepest pushed matrix.
+            int deepIndex = entry.depth - maxStackDepth;
+            if ((int)deepMatrices.size() <= deepIndex) deepMatrices.resize(deepIndex + 1);
+            relative = (deepIndex == 0)? local : MatrixMultiply(local, deepMatrices[deepIndex - 1]);
+            deepMatrices[deepIndex] = relative;
+        }
+
+        DrawAttachments(entry.node, entry.depth >= maxStackDepth, relative);
+        visited++;
+
+        // Children are drawn before the exit entry pops this node's matrix.
+        stack.push_back({ entry.node, entry.depth, true });
+        for (const GameTransform* child: entry.node->GetChildren())
+        {
+            stack.push_back({ child, entry.depth + 1, false });
+        }
+    }
+    return visited;
+}
+
+void HierarchyRenderer::DrawAttachments(const GameTransform* node, bool deep, Matrix relative)
+{
+    auto range = attachments.equal_range(node);
+    for (auto attachment = range.first; attachment != range.second; attachment++)
+    {
+        const RenderModel* model = attachment->second;
+        const Model& data = model->GetModel();
+        // DrawMesh applies the current rlgl matrix after the one given here.
+        Matrix meshMatrix = deep? MatrixMultiply(data.transform, relative) : data.transform;
+        for (int i = 0; i < data.meshCount; i++)
+        {
+            DrawMeshCounted(data.meshes[i], model->GetMeshMaterial(i), meshMatrix);
+        }
+    }
+}
+
+}
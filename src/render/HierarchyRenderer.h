@@ -0,0 +1,71 @@
+/*******************************************************************************************
+*
+*   HierarchyRenderer.h
+*   Definition of a HierarchyRenderer. Draws the models attached to a transform hierarchy
+*   in one depth first walk over the rlgl matrix stack: each node pushes its local matrix
+*   with rlPushMatrix/rlMultMatrixf and pops it after its children, so a hierarchy costs one
+*   matrix product per node instead of a GetLocalToWorldMatrix() per node.
+*
+*   Nodes deeper than the rlgl stack allows keep accumulating on the CPU instead, still one
+*   product per node.
+*
+*   LICENSE: GPLv3
+*
+*   Copyright (c) 2021 Juniper Dusk (@juniper-dusk)
+*
+*******************************************************************************************/
+
+#ifndef HIERARCHYRENDERER_H
+#define HIERARCHYRENDERER_H
+
+#include "raylib.h"
+#include "RenderModel.h"
+#include <transform/GameTransform.h>
+#include <unordered_map>
+#include <vector>
+
+namespace GameEngine
+{
+
+class HierarchyRenderer
+{
+public:
+    // Matrices pushed on the rlgl stack before switching to CPU accumulation. Leaves room
+    // for the matrices pushed by BeginMode3D below the 32 entry rlgl stack.
+    static const int maxStackDepth = 24;
+
+    // INITIALIZATION.
+    HierarchyRenderer();
+    // Disallow copies.
+    HierarchyRenderer(const HierarchyRenderer& copy) = delete;
+
+    // ATTACHMENTS.
+    // Draw a model at a transform. A transform can carry several models.
+    void Attach(const GameTransform* transform, const RenderModel* model);
+    void Detach(const GameTransform* transform);
+    void Clear();
+
+    // DRAWING.
+    // Draw every model attached to root or its descendants. Returns the nodes visited.
+    int DrawHierarchy(const GameTransform& root);
+
+protected:
+    typedef struct TraversalEntry
+    {
+        const GameTransform* node;
+        int depth;
+        // Set on the entry that pops the node's matrix once its children are drawn.
+        bool exit;
+    } TraversalEntry;
+
+    std::unordered_multimap<const GameTransform*, const RenderModel*> attachments;
+    std::vector<TraversalEntry> stack;
+    // Accumulated matrices of nodes past maxStackDepth, relative to the deepest rlgl matrix.
+    std::vector<Matrix> deepMatrices;
+
+    void DrawAttachments(const GameTransform* node, bool deep, Matrix relative);
+};
+
+}
+
+#endif // HIERARCHYRENDERER_H
@@ -0,0 +1,180 @@
+/*******************************************************************************************
+*
+*   HudText.cpp
+*   Implementation of a HudText cache.
+*
+*   LICENSE: GPLv3
+*
+*   Copyright (c) 2021 Juniper Dusk (@juniper-dusk)
+*
+*******************************************************************************************/
+
+#include "HudText.h"
+#include "RenderStats.h"
+#include "rlgl.h"
+#include <cmath>
+#include <cstdio>
+
+namespace GameEngine
+{
+
+HudText::HudText(int fontSize, Color color, int lineWidth) :
+    fontSize(fontSize),
+    color(color),
+    lineWidth(lineWidth),
+    reformatCount(0),
+    cache({ 0 }),
+    cacheRows(0)
+{
+}
+
+HudText::~HudText()
+{
+    if (cache.id > 0)
+    {
+        UnloadRenderTexture(cache);
+    }
+}
+
+int HudText::AddLine(const char* format, int precision, int posX, int posY)
+{
+    HudLine line = {};
+    line.format = format;
+    line.precision = precision;
+    line.posX = posX;
+    line.posY = posY;
+    for (int i = 0; i < maxLineValues; i++)
+    {
+        line.rounded[i] = 0;
+        line.values[i] = 0.0f;
+    }
+    line.valueCount = 0;
+    Format(line);
+    lines.push_back(line);
+    return (int)lines.size() - 1;
+}
+
+void HudText::SetValues(int line, std::initializer_list<float> values)
+{
+    HudLine& hudLine = lines.at(line);
+    const float precisionScale = powf(10.0f, (float)hudLine.precision);
+
+    bool changed = ((int)values.size() != hudLine.valueCount);
+    int index = 0;
+    for (float value: values)
+    {
+        if (index >= maxLineValues) break;
+        // Compare at display precision, so jitter below the last printed digit is ignored.
+        long long rounded = llroundf(value*precisionScale);
+        if (rounded != hudLine.rounded[index])
+        {
+            hudLine.rounded[index] = rounded;
+            changed = true;
+        }
+        hudLine.values[index] = value;
+        index++;
+    }
+    hudLine.valueCount = index;
+
+    if (changed) Format(hudLine);
+}
+
+const char* HudText::GetText(int line) const
+{
+    return lines.at(line).text;
+}
+
+int HudText::GetLineCount() const
+{
+    return (int)lines.size();
+}
+
+int HudText::TakeReformatCount()
+{
+    int count = reformatCount;
+    reformatCount = 0;
+    return count;
+}
+
+void HudText::Draw()
+{
+    RenderDirtyLines();
+
+    const int lineHeight = GetLineHeight();
+    for (int row = 0; row < (int)lines.size(); row++)
+    {
+        // Render textures are stored upside down, hence the negative height.
+        Rectangle source = {
+            0.0f,
+            (float)(cache.texture.height - (row + 1)*lineHeight),
+            (float)lineWidth,
+            (float)-lineHeight
+        };
+        DrawTextureRec(cache.texture, source, { (float)lines[row].posX, (float)lines[row].posY }, WHITE);
+        CountBatchedDraw(4);
+    }
+}
+
+void HudText::Format(HudLine& line)
+{
+    snprintf(line.text, maxLineLength, line.format.c_str(),
+             line.values[0], line.values[1], line.values[2], line.values[3]);
+    line.dirty = true;
+    reformatCount++;
+}
+
+void HudText::RenderDirtyLines()
+{
+    const int lineHeight = GetLineHeight();
+    if (cacheRows < (int)lines.size())
+    {
+        // Grow to the next power of two rows and render everything again.
+        int rows = (cacheRows > 0)? cacheRows : 8;
+        while (rows < (int)lines.size()) rows *= 2;
+        if (cache.id > 0) UnloadRenderTexture(cache);
+        cache = LoadRenderTexture(lineWidth, rows*lineHeight);
+        cacheRows = rows;
+        for (HudLine& line: lines) line.dirty = true;
+    }
+
+    bool anyDirty = false;
+    for (const HudLine& line: lines) anyDirty = anyDirty || line.dirty;
+    if (!anyDirty) return;
+
+    BeginTextureMode(cache);
+    for (int row = 0; row < (int)lines.size(); row++)
+    {
+        HudLine& line = lines[row];
+        if (!line.dirty) continue;
+
+        // Clear and redraw only this row. Scissor works in framebuffer space, bottom up.
+        rlDrawRenderBatchActive();
+        rlEnableScissorTest();
+        rlScissor(0, cache.texture.height - (row + 1)*lineHeight, lineWidth, lineHeight);
+        ClearBackground(BLANK);
+        DrawText(line.text, 0, row*lineHeight, fontSize, color);
+        CountBatchedDraw(CountGlyphVertices(line.text));
+        rlDrawRenderBatchActive();
+        rlDisableScissorTest();
+        line.dirty = false;
+    }
+    EndTextureMode();
+}
+
+int HudText::CountGlyphVertices(const char* text)
+{
+    // One quad per drawn glyph, raylib skips spaces and tabs.
+    int vertices = 0;
+    for (const char* c = text; *c != '\0'; c++)
+    {
+        if ((*c != ' ') && (*c != '\t') && (*c != '\n')) vertices += 4;
+    }
+    return vertices;
+}
+
+int HudText::GetLineHeight() const
+{
+    return fontSize + 2;
+}
+
+}
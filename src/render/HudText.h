@@ -0,0 +1,93 @@
+/*******************************************************************************************
+*
+*   HudText.h
+*   Definition of a HudText cache. Each line is a printf format plus up to four float
+*   values. Values are compared at display precision and a line is reformatted only when
+*   one of its rounded values changes. Formatted lines are rendered once into rows of a
+*   shared render texture, so unchanged lines are drawn as a single cached quad each.
+*
+*   LICENSE: GPLv3
+*
+*   Copyright (c) 2021 Juniper Dusk (@juniper-dusk)
+*
+*******************************************************************************************/
+
+#ifndef HUDTEXT_H
+#define HUDTEXT_H
+
+#include "raylib.h"
+#include <initializer_list>
+#include <string>
+#include <vector>
+
+namespace GameEngine
+{
+
+class HudText
+{
+public:
+    // Most values a line can format.
+    static const int maxLineValues = 4;
+    // Longest formatted line, including terminator.
+    static const int maxLineLength = 128;
+
+    // INITIALIZATION.
+    // Rows are lineWidth pixels wide, text is drawn at fontSize in color.
+    HudText(int fontSize, Color color, int lineWidth = 512);
+    // Disallow copies.
+    HudText(const HudText& copy) = delete;
+    virtual ~HudText();
+
+    // LINES.
+    // Add a line drawn at (posX, posY). Values are compared after rounding to precision
+    // decimals, which should match the format. Returns the line index.
+    int AddLine(const char* format, int precision, int posX, int posY);
+    // Set the values of a line. Reformats it only if a rounded value changed.
+    void SetValues(int line, std::initializer_list<float> values);
+    // Formatted text of a line.
+    const char* GetText(int line) const;
+    int GetLineCount() const;
+
+    // Lines reformatted since the last call.
+    int TakeReformatCount();
+
+    // DRAWING.
+    // Render changed lines into the cache, then draw every line. Call outside 3D mode.
+    void Draw();
+
+protected:
+    typedef struct HudLine
+    {
+        std::string format;
+        int precision;
+        int posX;
+        int posY;
+        // Values rounded to display precision, as last formatted.
+        long long rounded[maxLineValues];
+        float values[maxLineValues];
+        int valueCount;
+        char text[maxLineLength];
+        // Row in the render texture is out of date.
+        bool dirty;
+    } HudLine;
+
+    std::vector<HudLine> lines;
+    int fontSize;
+    Color color;
+    int lineWidth;
+    int reformatCount;
+
+    // Row cache, grown when lines are added.
+    RenderTexture2D cache;
+    int cacheRows;
+
+    void Format(HudLine& line);
+    void RenderDirtyLines();
+    // Vertices DrawText submits for a line.
+    static int CountGlyphVertices(const char* text);
+    int GetLineHeight() const;
+};
+
+}
+
+#endif // HUDTEXT_H
@@ -0,0 +1,213 @@
+/*******************************************************************************************
+*
+*   InstanceBatch.cpp
+*   Implementation of an InstanceBatcher. Groups world matrices by mesh and material and
+*   submits each group with DrawMeshInstanced.
+*
+*   LICENSE: GPLv3
+*
+*   Copyright (c) 2021 Juniper Dusk (@juniper-dusk)
+*
+*******************************************************************************************/
+
+#include "InstanceBatch.h"
+#include "RenderStats.h"
+#include "raymath.h"
+#include <algorithm>
+#include <functional>
+#include <unordered_map>
+
+namespace GameEngine
+{
+
+// Instancing support per shader, keyed by its program id. GL reuses an id only once the
+// program is deleted, so shaders are forgotten before they are unloaded.
+static std::unordered_map<unsigned int, bool> instancingShaders;
+
+bool InstanceBatcher::BatchKey::operator==(const BatchKey& other) const
+{
+    return (mesh == other.mesh) && (material == other.material);
+}
+
+size_t InstanceBatcher::BatchKeyHash::operator()(const BatchKey& key) const
+{
+    size_t meshHash = std::hash<const void*>()(key.mesh);
+    size_t materialHash = std::hash<const void*>()(key.material);
+    return meshHash ^ (materialHash + 0x9e3779b9 + (meshHash << 6) + (meshHash >> 2));
+}
+
+InstanceBatcher::InstanceBatcher() :
+    ring(nullptr)
+{
+}
+
+void InstanceBatcher::SetInstanceRing(InstanceRing* ring)
+{
+    this->ring = ring;
+}
+
+void InstanceBatcher::Begin()
+{
+    // Keep batches and their capacity, so a steady scene does not allocate per frame.
+    for (InstanceBatch& batch: batches)
+    {
+        batch.transforms.clear();
+        batch.sources.clear();
+    }
+}
+
+void InstanceBatcher::Add(const Mesh& mesh, const Material& material, Matrix worldMatrix)
+{
+    FindBatch(mesh, material).transforms.push_back(worldMatrix);
+}
+
+void InstanceBatcher::Add(const Mesh& mesh, const Material& material, const GameTransform& transform)
+{
+    FindBatch(mesh, material).sources.push_back(&transform);
+}
+
+void InstanceBatcher::AddModel(const Model& model, const GameTransform& transform)
+{
+    // Same combination DrawModel performs: model transform first, then world.
+    Matrix worldMatrix = MatrixMultiply(model.transform, transform.GetLocalToWorldMatrix());
+    for (int i = 0; i < model.meshCount; i++)
+    {
+        Add(model.meshes[i], model.materials[model.meshMaterial[i]], worldMatrix);
+    }
+}
+
+void InstanceBatcher::Clear()
+{
+    batches.clear();
+    batchIndices.clear();
+}
+
+size_t InstanceBatcher::GetBatchCount() const
+{
+    return batches.size();
+}
+
+const InstanceBatch& InstanceBatcher::GetBatch(size_t index) const
+{
+    return batches.at(index);
+}
+
+size_t InstanceBatcher::GetInstanceCount() const
+{
+    size_t instanceCount = 0;
+    for (const InstanceBatch& batch: batches)
+    {
+        instanceCount += batch.transforms.size() + batch.sources.size();
+    }
+    return instanceCount;
+}
+
+int InstanceBatcher::Draw()
+{
+    // Write every batch into the ring before the first draw, so the frame uploads once.
+    ranges.assign(batches.size(), { nullptr, 0, 0 });
+    for (size_t i = 0; (ring != nullptr) && (i < batches.size()); i++)
+    {
+        const InstanceBatch& batch = batches[i];
+        int count = (int)(batch.transforms.size() + batch.sources.size());
+        if ((count == 0) || !batch.instanced) continue;
+        if (batch.transforms.empty())
+        {
+            // Only transforms, their world matrices go straight into the ring.
+            ranges[i] = ring->WriteWorldMatrices(batch.sources.data(), count);
+            continue;
+        }
+        ranges[i] = ring->Allocate(count);
+        if (ranges[i].count == 0) continue;
+        Matrix* matrices = std::copy(batch.transforms.begin(), batch.transforms.end(), ranges[i].matrices);
+        for (const GameTransform* source: batch.sources)
+        {
+            *matrices++ = source->GetLocalToWorldMatrix();
+        }
+    }
+
+    int drawCalls = 0;
+    for (size_t i = 0; i < batches.size(); i++)
+    {
+        InstanceBatch& batch = batches[i];
+        if (batch.transforms.empty() && batch.sources.empty()) continue;
+
+        if (ranges[i].count > 0)
+        {
+            ring->Draw(batch.mesh, batch.material, ranges[i]);
+            drawCalls++;
+        }
+        else if (batch.instanced)
+        {
+            // No ring, or it is full this frame.
+            Matrix* transforms = batch.transforms.data();
+            int count = (int)batch.transforms.size();
+            if (!batch.sources.empty())
+            {
+                batchTransforms.assign(batch.transforms.begin(), batch.transforms.end());
+                for (const GameTransform* source: batch.sources)
+                {
+                    batchTransforms.push_back(source->GetLocalToWorldMatrix());
+                }
+                transforms = batchTransforms.data();
+                count = (int)batchTransforms.size();
+            }
+            DrawMeshInstancedCounted(batch.mesh, batch.material, transforms, count);
+            drawCalls++;
+        }
+        else
+        {
+            // Shader has no per-instance matrix attribute, fall back to one draw per instance.
+            for (const Matrix& transform: batch.transforms)
+            {
+                DrawMeshCounted(batch.mesh, batch.material, transform);
+                drawCalls++;
+            }
+            for (const GameTransform* source: batch.sources)
+            {
+                DrawMeshCounted(batch.mesh, batch.material, source->GetLocalToWorldMatrix());
+                drawCalls++;
+            }
+        }
+    }
+    return drawCalls;
+}
+
+InstanceBatch& InstanceBatcher::FindBatch(const Mesh& mesh, const Material& material)
+{
+    BatchKey key = { mesh.vertices, material.maps };
+    auto found = batchIndices.find(key);
+    if (found != batchIndices.end())
+    {
+        return batches[found->second];
+    }
+    // First instance of this mesh/material pair.
+    batchIndices[key] = batches.size();
+    batches.push_back({ mesh, material, SupportsInstancing(material), {}, {} });
+    return batches.back();
+}
+
+bool InstanceBatcher::SupportsInstancing(const Material& material)
+{
+    // DrawMeshInstanced feeds the instance matrices through the model matrix attribute.
+    const int* locs = material.shader.locs;
+    if ((locs == nullptr) || (locs[SHADER_LOC_MATRIX_MODEL] == -1)) return false;
+
+    auto found = instancingShaders.find(material.shader.id);
+    if (found != instancingShaders.end()) return found->second;
+    bool supported = (GetShaderLocationAttrib(material.shader, "instanceTransform") == locs[SHADER_LOC_MATRIX_MODEL]);
+    instancingShaders.emplace(material.shader.id, supported);
+    return supported;
+}
+
+void InstanceBatcher::SetSupportsInstancing(const Shader& shader, bool supported)
+{
+    instancingShaders[shader.id] = supported;
+}
+
+void InstanceBatcher::ForgetShader(const Shader& shader)
+{
+    instancingShaders.erase(shader.id);
+}
+
+}
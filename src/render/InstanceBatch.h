@@ -0,0 +1,117 @@
+/*******************************************************************************************
+*
+*   InstanceBatch.h
+*   Definition of an InstanceBatcher. Gathers the world matrices of every transform that
+*   shares a mesh and material into one contiguous array, so that each mesh/material pair
+*   is submitted with a single DrawMeshInstanced call instead of one DrawMesh per object.
+*
+*   Batch building only touches CPU memory and can be used without a window or GL context.
+*   With an InstanceRing set, batches are drawn from the ring's long-lived buffer instead,
+*   and instances queued by transform have their world matrices written straight into it.
+*
+*   LICENSE: GPLv3
+*
+*   Copyright (c) 2021 Juniper Dusk (@juniper-dusk)
+*
+*******************************************************************************************/
+
+#ifndef INSTANCEBATCH_H
+#define INSTANCEBATCH_H
+
+#include "raylib.h"
+#include "InstanceRing.h"
+#include <transform/GameTransform.h>
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
+
+namespace GameEngine
+{
+
+// All instances of one mesh drawn with one material.
+typedef struct InstanceBatch
+{
+    Mesh mesh;
+    Material material;
+    // Whether the material's shader reads per-instance matrices, looked up once when the
+    // batch is created.
+    bool instanced;
+    // Instances queued by world matrix.
+    std::vector<Matrix> transforms;
+    // Instances queued by transform, their world matrices are read when drawn.
+    std::vector<const GameTransform*> sources;
+} InstanceBatch;
+
+class InstanceBatcher
+{
+public:
+    // INITIALIZATION.
+    InstanceBatcher();
+    // Disallow copies.
+    InstanceBatcher(const InstanceBatcher& copy) = delete;
+    // Draw instanced batches from this ring, or with DrawMeshInstanced when null. The
+    // ring's frame must be begun before Draw() and ended after it.
+    void SetInstanceRing(InstanceRing* ring);
+
+    // BATCH BUILDING.
+    // Start a new frame. Empties every batch but keeps its storage for reuse.
+    void Begin();
+    // Queue one instance of a mesh at the given world matrix.
+    void Add(const Mesh& mesh, const Material& material, Matrix worldMatrix);
+    // Queue one instance of a mesh at the transform's world matrix. The matrix is read in
+    // Draw() and written straight into the ring, so the transform must outlive the frame.
+    void Add(const Mesh& mesh, const Material& material, const GameTransform& transform);
+    // Queue every mesh of a model, combined with the model's own transform.
+    void AddModel(const Model& model, const GameTransform& transform);
+    // Drop all batches and release their storage.
+    void Clear();
+
+    // BATCH QUERIES.
+    // Number of batches, including ones left empty this frame.
+    size_t GetBatchCount() const;
+    const InstanceBatch& GetBatch(size_t index) const;
+    // Number of instances queued this frame over all batches.
+    size_t GetInstanceCount() const;
+
+    // SUBMISSION.
+    // Draw every non-empty batch. Returns the number of draw calls issued.
+    int Draw();
+    // Whether the material's shader reads a per-instance world matrix. Lit shaders also
+    // fill locs[SHADER_LOC_MATRIX_MODEL], with the matModel uniform, so the location only
+    // counts when it is the shader's "instanceTransform" attribute. The answer is cached
+    // per shader id; batches and queued materials keep it from when they were created.
+    static bool SupportsInstancing(const Material& material);
+    // Mark a shader as reading per-instance matrices at locs[SHADER_LOC_MATRIX_MODEL] or
+    // not, for attributes with another name or shaders used without a GL context.
+    static void SetSupportsInstancing(const Shader& shader, bool supported);
+    // Drop the cached answer for a shader. Call before UnloadShader(), since a shader
+    // loaded later may get the same id.
+    static void ForgetShader(const Shader& shader);
+
+protected:
+    // Batches are identified by the mesh vertex data and material maps they point to.
+    typedef struct BatchKey
+    {
+        const void* mesh;
+        const void* material;
+        bool operator==(const BatchKey& other) const;
+    } BatchKey;
+    typedef struct BatchKeyHash
+    {
+        size_t operator()(const BatchKey& key) const;
+    } BatchKeyHash;
+
+    std::vector<InstanceBatch> batches;
+    std::unordered_map<BatchKey, size_t, BatchKeyHash> batchIndices;
+    InstanceRing* ring;
+    // Ring range of every batch during Draw().
+    std::vector<InstanceRange> ranges;
+    // Matrices of one batch drawn without the ring.
+    std::vector<Matrix> batchTransforms;
+
+    InstanceBatch& FindBatch(const Mesh& mesh, const Material& material);
+};
+
+}
+
+#endif // INSTANCEBATCH_H
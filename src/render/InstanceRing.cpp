@@ -0,0 +1,239 @@
+/*******************************************************************************************
+*
+*   InstanceRing.cpp
+*   Implementation of an InstanceRing.
+*
+*   LICENSE: GPLv3
+*
+*   Copyright (c) 2021 Juniper Dusk (@juniper-dusk)
+*
+*******************************************************************************************/
+
+#include "InstanceRing.h"
+#include "InstanceBatch.h"
+#include "RenderStats.h"
+#include "raymath.h"
+#include "rlgl.h"
+
+namespace GameEngine
+{
+
+void* CpuInstanceRingBackend::Map(size_t size)
+{
+    storage.assign(size, 0);
+    return storage.data();
+}
+
+void CpuInstanceRingBackend::Release()
+{
+    storage.clear();
+    storage.shrink_to_fit();
+}
+
+void CpuInstanceRingBackend::Flush(size_t /*offset*/, size_t size)
+{
+    flushedBytes += size;
+}
+
+unsigned int CpuInstanceRingBackend::GetBufferId() const
+{
+    return 0;
+}
+
+size_t CpuInstanceRingBackend::GetFlushedBytes() const
+{
+    return flushedBytes;
+}
+
+RlglInstanceRingBackend::~RlglInstanceRingBackend()
+{
+    Release();
+}
+
+void* RlglInstanceRingBackend::Map(size_t size)
+{
+    Release();
+    shadow.assign(size, 0);
+    // Created once at full size, frames only ever update ranges of it.
+    bufferId = rlLoadVertexBuffer(nullptr, (int)size, true);
+    return shadow.data();
+}
+
+void RlglInstanceRingBackend::Release()
+{
+    if (bufferId > 0)
+    {
+        rlUnloadVertexBuffer(bufferId);
+        bufferId = 0;
+    }
+    shadow.clear();
+    shadow.shrink_to_fit();
+}
+
+void RlglInstanceRingBackend::Flush(size_t offset, size_t size)
+{
+    if ((bufferId == 0) || (size == 0)) return;
+    rlUpdateVertexBuffer(bufferId, shadow.data() + offset, (int)size, (int)offset);
+}
+
+unsigned int RlglInstanceRingBackend::GetBufferId() const
+{
+    return bufferId;
+}
+
+InstanceRing::InstanceRing(InstanceRingBackend* backend, int capacity, int frameRegions) :
+    backend(backend),
+    capacity(capacity),
+    frameRegions(frameRegions),
+    frameSlot(frameRegions - 1),
+    frameUsed(0),
+    frameFlushed(0),
+    ring(nullptr)
+{
+    ring = (Matrix*)backend->Map((size_t)capacity*frameRegions*sizeof(Matrix));
+}
+
+InstanceRing::~InstanceRing()
+{
+    backend->Release();
+}
+
+void InstanceRing::BeginFrame()
+{
+    frameSlot = (frameSlot + 1) % frameRegions;
+    frameUsed = 0;
+    frameFlushed = 0;
+}
+
+void InstanceRing::EndFrame()
+{
+    FlushFrame();
+}
+
+InstanceRange InstanceRing::Allocate(int count)
+{
+    if ((count <= 0) || (count > GetAvailable())) return { nullptr, 0, 0 };
+
+    size_t first = (size_t)frameSlot*capacity + frameUsed;
+    frameUsed += count;
+    return { ring + first, first*sizeof(Matrix), count };
+}
+
+InstanceRange InstanceRing::WriteWorldMatrices(const GameTransform* const* transforms, int count)
+{
+    InstanceRange range = Allocate(count);
+    for (int i = 0; i < range.count; i++)
+    {
+        range.matrices[i] = transforms[i]->GetLocalToWorldMatrix();
+    }
+    return range;
+}
+
+int InstanceRing::GetAvailable() const
+{
+    return capacity - frameUsed;
+}
+
+// Whether a material map is sampled as a cubemap, as raylib decides when drawing.
+static bool IsCubemapMap(int map)
+{
+    return (map == MATERIAL_MAP_CUBEMAP) || (map == MATERIAL_MAP_IRRADIANCE) || (map == MATERIAL_MAP_PREFILTER);
+}
+
+void InstanceRing::Draw(const Mesh& mesh, const Material& material, const InstanceRange& range)
+{
+    if (range.count <= 0) return;
+    FlushFrame();
+
+    if (!InstanceBatcher::SupportsInstancing(material))
+    {
+        // Shader has no per-instance matrix attribute, fall back to one draw per instance.
+        for (int i = 0; i < range.count; i++)
+        {
+            DrawMeshCounted(mesh, material, range.matrices[i]);
+        }
+        return;
+    }
+    unsigned int bufferId = backend->GetBufferId();
+    if ((bufferId == 0) || rlIsStereoRenderEnabled() || !rlEnableVertexArray(mesh.vaoId))
+    {
+        // No ring on the GPU, or a path only raylib handles, let raylib upload the matrices.
+        DrawMeshInstancedCounted(mesh, material, range.matrices, range.count);
+        return;
+    }
+    CountDraw(mesh, material, range.count, 0);
+    const int* locs = material.shader.locs;
+
+    rlEnableShader(material.shader.id);
+    if (locs[SHADER_LOC_COLOR_DIFFUSE] != -1)
+    {
+        Color tint = material.maps[MATERIAL_MAP_DIFFUSE].color;
+        float values[4] = { tint.r/255.0f, tint.g/255.0f, tint.b/255.0f, tint.a/255.0f };
+        rlSetUniform(locs[SHADER_LOC_COLOR_DIFFUSE], values, SHADER_UNIFORM_VEC4, 1);
+    }
+    if (locs[SHADER_LOC_COLOR_SPECULAR] != -1)
+    {
+        Color tint = material.maps[MATERIAL_MAP_SPECULAR].color;
+        float values[4] = { tint.r/255.0f, tint.g/255.0f, tint.b/255.0f, tint.a/255.0f };
+        rlSetUniform(locs[SHADER_LOC_COLOR_SPECULAR], values, SHADER_UNIFORM_VEC4, 1);
+    }
+
+    Matrix view = rlGetMatrixModelview();
+    Matrix projection = rlGetMatrixProjection();
+    if (locs[SHADER_LOC_MATRIX_VIEW] != -1) rlSetUniformMatrix(locs[SHADER_LOC_MATRIX_VIEW], view);
+    if (locs[SHADER_LOC_MATRIX_PROJECTION] != -1) rlSetUniformMatrix(locs[SHADER_LOC_MATRIX_PROJECTION], projection);
+
+    // Point the per-instance matrix attribute at this range of the ring.
+    int modelLoc = locs[SHADER_LOC_MATRIX_MODEL];
+    rlEnableVertexBuffer(bufferId);
+    for (unsigned int column = 0; column < 4; column++)
+    {
+        rlEnableVertexAttribute(modelLoc + column);
+        rlSetVertexAttribute(modelLoc + column, 4, RL_FLOAT, false, sizeof(Matrix),
+            (void*)(range.offset + column*sizeof(Vector4)));
+        rlSetVertexAttributeDivisor(modelLoc + column, 1);
+    }
+    rlDisableVertexBuffer();
+
+    // Instances carry their own world matrix, the shared model matrix is only the rlgl transform.
+    Matrix model = rlGetMatrixTransform();
+    if (locs[SHADER_LOC_MATRIX_NORMAL] != -1) rlSetUniformMatrix(locs[SHADER_LOC_MATRIX_NORMAL], MatrixTranspose(MatrixInvert(model)));
+
+    for (int i = 0; i < MAX_MATERIAL_MAPS; i++)
+    {
+        unsigned int textureId = material.maps[i].texture.id;
+        if (textureId == 0) continue;
+        rlActiveTextureSlot(i);
+        if (IsCubemapMap(i)) rlEnableTextureCubemap(textureId);
+        else rlEnableTexture(textureId);
+        rlSetUniform(locs[SHADER_LOC_MAP_DIFFUSE + i], &i, SHADER_UNIFORM_INT, 1);
+    }
+
+    Matrix modelView = MatrixMultiply(model, view);
+    rlSetUniformMatrix(locs[SHADER_LOC_MATRIX_MVP], MatrixMultiply(modelView, projection));
+
+    if (mesh.indices) rlDrawVertexArrayElementsInstanced(0, mesh.triangleCount*3, 0, range.count);
+    else rlDrawVertexArrayInstanced(0, mesh.vertexCount, range.count);
+
+    for (int i = 0; i < MAX_MATERIAL_MAPS; i++)
+    {
+        if (material.maps[i].texture.id == 0) continue;
+        rlActiveTextureSlot(i);
+        if (IsCubemapMap(i)) rlDisableTextureCubemap();
+        else rlDisableTexture();
+    }
+    rlDisableVertexArray();
+    rlDisableShader();
+}
+
+void InstanceRing::FlushFrame()
+{
+    if (frameFlushed == frameUsed) return;
+    size_t first = (size_t)frameSlot*capacity + frameFlushed;
+    backend->Flush(first*sizeof(Matrix), (size_t)(frameUsed - frameFlushed)*sizeof(Matrix));
+    // Without a GPU buffer the matrices are uploaded by the fallback draw instead.
+    if (backend->GetBufferId() > 0) CountMatrixUploads(frameUsed - frameFlushed);
+    frameFlushed = frameUsed;
+}
+
+}
@@ -0,0 +1,135 @@
+/*******************************************************************************************
+*
+*   InstanceRing.h
+*   Definition of an InstanceRing. One long-lived instance buffer split into per-frame
+*   regions: world matrices are written into this frame's region, uploaded with one buffer
+*   update per flush and drawn from their offset in the buffer, so no instance buffer is
+*   created and destroyed per draw as DrawMeshInstanced does. Consecutive frames write
+*   different regions, so an update never overwrites matrices that the previous frame's
+*   draws may still read. There are no fences: ordering is left to the driver.
+*
+*   Memory comes from a backend. CpuInstanceRingBackend keeps the ring in plain memory and
+*   runs without a GL context. RlglInstanceRingBackend owns one dynamic vertex buffer; rlgl
+*   exposes neither persistent mapping nor fences, so matrices go into a CPU copy of the
+*   buffer and each flushed range is uploaded with rlUpdateVertexBuffer.
+*
+*   LICENSE: GPLv3
+*
+*   Copyright (c) 2021 Juniper Dusk (@juniper-dusk)
+*
+*******************************************************************************************/
+
+#ifndef INSTANCERING_H
+#define INSTANCERING_H
+
+#include "raylib.h"
+#include <transform/GameTransform.h>
+#include <cstddef>
+#include <vector>
+
+namespace GameEngine
+{
+
+// Where the ring's memory lives.
+class InstanceRingBackend
+{
+public:
+    virtual ~InstanceRingBackend() {}
+    // Create storage for size bytes and return a pointer that stays valid until Release().
+    virtual void* Map(size_t size) = 0;
+    virtual void Release() = 0;
+    // Make bytes written in [offset, offset + size) visible to the GPU.
+    virtual void Flush(size_t offset, size_t size) = 0;
+    // Vertex buffer holding the ring, 0 if there is none.
+    virtual unsigned int GetBufferId() const = 0;
+};
+
+class CpuInstanceRingBackend : public InstanceRingBackend
+{
+public:
+    void* Map(size_t size) override;
+    void Release() override;
+    void Flush(size_t offset, size_t size) override;
+    unsigned int GetBufferId() const override;
+
+    // Bytes flushed since creation, for tests.
+    size_t GetFlushedBytes() const;
+
+protected:
+    std::vector<unsigned char> storage;
+    size_t flushedBytes = 0;
+};
+
+class RlglInstanceRingBackend : public InstanceRingBackend
+{
+public:
+    ~RlglInstanceRingBackend() override;
+    void* Map(size_t size) override;
+    void Release() override;
+    void Flush(size_t offset, size_t size) override;
+    unsigned int GetBufferId() const override;
+
+protected:
+    std::vector<unsigned char> shadow;
+    unsigned int bufferId = 0;
+};
+
+// Instances written for one draw.
+typedef struct InstanceRange
+{
+    Matrix* matrices;
+    // Offset in bytes from the start of the ring buffer.
+    size_t offset;
+    int count;
+} InstanceRange;
+
+class InstanceRing
+{
+public:
+    // INITIALIZATION.
+    // Room for capacity matrices per frame, in frameRegions regions used in turn.
+    InstanceRing(InstanceRingBackend* backend, int capacity, int frameRegions = 2);
+    // Disallow copies.
+    InstanceRing(const InstanceRing& copy) = delete;
+    virtual ~InstanceRing();
+
+    // FRAMES.
+    // Move to the next frame's region.
+    void BeginFrame();
+    // Flush what this frame wrote.
+    void EndFrame();
+
+    // ALLOCATION.
+    // Room for count matrices in this frame's region. Returns a range with no matrices
+    // when the region is full.
+    InstanceRange Allocate(int count);
+    // Allocate and fill with the world matrices of the given transforms.
+    InstanceRange WriteWorldMatrices(const GameTransform* const* transforms, int count);
+    // Matrices left in this frame's region.
+    int GetAvailable() const;
+
+    // DRAWING.
+    // Draw a mesh once per matrix in range, reading them straight from the ring buffer.
+    // Binds the same state DrawMeshInstanced does: colors, view, projection and normal
+    // matrices and every material map. Without a GPU buffer, with stereo rendering or a
+    // shader that is not instanced, the draw goes through raylib instead. Matrices written
+    // since the last draw are flushed first, so write a frame's ranges before drawing
+    // them to upload once. Call EndFrame() after the frame's draws.
+    void Draw(const Mesh& mesh, const Material& material, const InstanceRange& range);
+
+protected:
+    InstanceRingBackend* backend;
+    int capacity;
+    int frameRegions;
+    int frameSlot;
+    int frameUsed;
+    // Matrices of this frame already flushed to the backend.
+    int frameFlushed;
+    Matrix* ring;
+
+    void FlushFrame();
+};
+
+}
+
+#endif // INSTANCERING_H
@@ -0,0 +1,82 @@
+/*******************************************************************************************
+*
+*   MaterialState.cpp
+*   Implementation of a MaterialState.
+*
+*   LICENSE: GPLv3
+*
+*   Copyright (c) 2021 Juniper Dusk (@juniper-dusk)
+*
+*******************************************************************************************/
+
+#include "MaterialState.h"
+#include <functional>
+
+namespace GameEngine
+{
+
+MaterialState MaterialState::FromMaterial(const Material& material)
+{
+    MaterialState state = { };
+    state.shader = material.shader.id;
+    if (material.maps != nullptr)
+    {
+        for (int i = 0; i < MAX_MATERIAL_MAPS; i++)
+        {
+            state.textures[i] = material.maps[i].texture.id;
+            state.colors[i] = material.maps[i].color;
+            state.values[i] = material.maps[i].value;
+        }
+    }
+    for (int i = 0; i < 4; i++) state.params[i] = material.params[i];
+    return state;
+}
+
+bool MaterialState::operator==(const MaterialState& other) const
+{
+    if (shader != other.shader) return false;
+    for (int i = 0; i < MAX_MATERIAL_MAPS; i++)
+    {
+        if ((textures[i] != other.textures[i]) || (values[i] != other.values[i]) ||
+            (colors[i].r != other.colors[i].r) || (colors[i].g != other.colors[i].g) ||
+            (colors[i].b != other.colors[i].b) || (colors[i].a != other.colors[i].a))
+        {
+            return false;
+        }
+    }
+    for (int i = 0; i < 4; i++)
+    {
+        if (params[i] != other.params[i]) return false;
+    }
+    return true;
+}
+
+bool MaterialState::operator!=(const MaterialState& other) const
+{
+    return !(*this == other);
+}
+
+static void HashCombine(size_t* hash, size_t value)
+{
+    *hash ^= value + 0x9e3779b9 + (*hash << 6) + (*hash >> 2);
+}
+
+size_t MaterialStateHash::operator()(const MaterialState& state) const
+{
+    size_t hash = std::hash<unsigned int>()(state.shader);
+    for (int i = 0; i < MAX_MATERIAL_MAPS; i++)
+    {
+        const Color& color = state.colors[i];
+        unsigned int packed = (color.r << 24) | (color.g << 16) | (color.b << 8) | color.a;
+        HashCombine(&hash, std::hash<unsigned int>()(state.textures[i]));
+        HashCombine(&hash, std::hash<unsigned int>()(packed));
+        HashCombine(&hash, std::hash<float>()(state.values[i]));
+    }
+    for (int i = 0; i < 4; i++)
+    {
+        HashCombine(&hash, std::hash<float>()(state.params[i]));
+    }
+    return hash;
+}
+
+}
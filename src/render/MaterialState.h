@@ -0,0 +1,48 @@
+/*******************************************************************************************
+*
+*   MaterialState.h
+*   Definition of a MaterialState. Everything a Material binds when a mesh is drawn: the
+*   shader, then texture, color and value of every map, and the generic parameters. Two
+*   materials with equal state can be drawn interchangeably, which lets draws from
+*   different models be grouped and merged.
+*
+*   LICENSE: GPLv3
+*
+*   Copyright (c) 2021 Juniper Dusk (@juniper-dusk)
+*
+*******************************************************************************************/
+
+#ifndef MATERIALSTATE_H
+#define MATERIALSTATE_H
+
+#include "raylib.h"
+#include <cstddef>
+
+#ifndef MAX_MATERIAL_MAPS
+    #define MAX_MATERIAL_MAPS 12    // Maximum number of maps per material, as in raylib config.h
+#endif
+
+namespace GameEngine
+{
+
+typedef struct MaterialState
+{
+    unsigned int shader;
+    unsigned int textures[MAX_MATERIAL_MAPS];
+    Color colors[MAX_MATERIAL_MAPS];
+    float values[MAX_MATERIAL_MAPS];
+    float params[4];
+
+    static MaterialState FromMaterial(const Material& material);
+    bool operator==(const MaterialState& other) const;
+    bool operator!=(const MaterialState& other) const;
+} MaterialState;
+
+typedef struct MaterialStateHash
+{
+    size_t operator()(const MaterialState& state) const;
+} MaterialStateHash;
+
+}
+
+#endif // MATERIALSTATE_H
@@ -0,0 +1,118 @@
+/*******************************************************************************************
+*
+*   RenderModel.cpp
+*   Implementation of a RenderModel. Draws every mesh of a model at a transform, using
+*   premultiplied tints and a cached world matrix.
+*
+*   LICENSE: GPLv3
+*
+*   Copyright (c) 2021 Juniper Dusk (@juniper-dusk)
+*
+*******************************************************************************************/
+
+#include "RenderModel.h"
+#include "RenderStats.h"
+#include "raymath.h"
+
+namespace GameEngine
+{
+
+RenderModel::RenderModel(Model model, const GameTransform* transform, Color tint) :
+    model(model),
+    transform(transform),
+    tint(tint),
+    worldMatrix(MatrixIdentity()),
+    worldVersion(0),
+    worldValid(false)
+{
+    RefreshMaterials();
+}
+
+Color RenderModel::GetTint() const
+{
+    return tint;
+}
+
+void RenderModel::SetTint(Color tint)
+{
+    this->tint = tint;
+    RefreshMaterials();
+}
+
+void RenderModel::RefreshMaterials()
+{
+    materials.assign(model.materials, model.materials + model.materialCount);
+    materialMaps.resize(model.materialCount*MAX_MATERIAL_MAPS);
+
+    for (int i = 0; i < model.materialCount; i++)
+    {
+        // Private copy of the maps, so the shared material is never written to.
+        MaterialMap* maps = &materialMaps[i*MAX_MATERIAL_MAPS];
+        for (int map = 0; map < MAX_MATERIAL_MAPS; map++)
+        {
+            maps[map] = model.materials[i].maps[map];
+        }
+        maps[MATERIAL_MAP_DIFFUSE].color = TintColor(maps[MATERIAL_MAP_DIFFUSE].color, tint);
+        materials[i].maps = maps;
+    }
+}
+
+const GameTransform* RenderModel::GetTransform() const
+{
+    return transform;
+}
+
+void RenderModel::SetTransform(const GameTransform* transform)
+{
+    this->transform = transform;
+    worldValid = false;
+}
+
+Matrix RenderModel::GetWorldMatrix()
+{
+    if (!transform)
+    {
+        return model.transform;
+    }
+    unsigned int version = transform->GetWorldVersion();
+    if (!worldValid || (version != worldVersion))
+    {
+        // Combine model transformation matrix (model.transform) with the world matrix.
+        worldMatrix = MatrixMultiply(model.transform, transform->GetLocalToWorldMatrix());
+        worldVersion = version;
+        worldValid = true;
+    }
+    return worldMatrix;
+}
+
+const Model& RenderModel::GetModel() const
+{
+    return model;
+}
+
+const Material& RenderModel::GetMeshMaterial(int meshIndex) const
+{
+    return materials[model.meshMaterial[meshIndex]];
+}
+
+void RenderModel::Draw()
+{
+    Matrix world = GetWorldMatrix();
+    for (int i = 0; i < model.meshCount; i++)
+    {
+        DrawMeshCounted(model.meshes[i], materials[model.meshMaterial[i]], world);
+    }
+}
+
+Color RenderModel::TintColor(Color color, Color tint)
+{
+    // Integer equivalent of (color/255)*(tint/255)*255, rounded.
+    return {
+        (unsigned char)((color.r*tint.r + 127)/255),
+        (unsigned char)((color.g*tint.g + 127)/255),
+        (unsigned char)((color.b*tint.b + 127)/255),
+        (unsigned char)((color.a*tint.a + 127)/255)
+    };
+}
+
+}
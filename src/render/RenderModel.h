@@ -0,0 +1,79 @@
+/*******************************************************************************************
+*
+*   RenderModel.h
+*   Definition of a RenderModel. Draws a Model at a GameTransform without touching the
+*   model's shared materials: diffuse colors are premultiplied by the tint once, into
+*   private copies of the material maps, and the model.transform x world matrix is cached
+*   until the transform changes.
+*
+*   LICENSE: GPLv3
+*
+*   Copyright (c) 2021 Juniper Dusk (@juniper-dusk)
+*
+*******************************************************************************************/
+
+#ifndef RENDERMODEL_H
+#define RENDERMODEL_H
+
+#include "raylib.h"
+#include <transform/GameTransform.h>
+#include <vector>
+
+#ifndef MAX_MATERIAL_MAPS
+    #define MAX_MATERIAL_MAPS 12    // Maximum number of maps per material, as in raylib config.h
+#endif
+
+namespace GameEngine
+{
+
+class RenderModel
+{
+public:
+    // INITIALIZATION.
+    // Bind a model to a transform, drawn with the given tint.
+    RenderModel(Model model, const GameTransform* transform, Color tint = WHITE);
+    // Disallow copies, materials point into our own map storage.
+    RenderModel(const RenderModel& copy) = delete;
+    RenderModel(RenderModel&& other) = default;
+
+    // TINT PROPERTY.
+    Color GetTint() const;
+    void SetTint(Color tint);
+    // Re-read the model materials, after a texture or color was changed on them.
+    void RefreshMaterials();
+
+    // TRANSFORM PROPERTY.
+    const GameTransform* GetTransform() const;
+    void SetTransform(const GameTransform* transform);
+    // Model transform combined with the transform's world matrix.
+    Matrix GetWorldMatrix();
+
+    // Model data, as passed in.
+    const Model& GetModel() const;
+    // Material used to draw a mesh, with the tint applied.
+    const Material& GetMeshMaterial(int meshIndex) const;
+
+    // DRAWING.
+    void Draw();
+
+    // Multiply two colors channel by channel, as DrawModel does with tints.
+    static Color TintColor(Color color, Color tint);
+
+protected:
+    Model model;
+    const GameTransform* transform;
+    Color tint;
+
+    // Shallow material copies, each pointing at its own block of maps.
+    std::vector<Material> materials;
+    std::vector<MaterialMap> materialMaps;
+
+    // Cached model.transform x world, valid for one version of the transform.
+    Matrix worldMatrix;
+    unsigned int worldVersion;
+    bool worldValid;
+};
+
+}
+
+#endif // RENDERMODEL_H
@@ -0,0 +1,257 @@
+/*******************************************************************************************
+*
+*   RenderQueue.cpp
+*   Implementation of a RenderQueue. Builds draw keys, sorts them with an 8 bit LSD radix
+*   sort and submits draws in key order.
+*
+*   LICENSE: GPLv3
+*
+*   Copyright (c) 2021 Juniper Dusk (@juniper-dusk)
+*
+*******************************************************************************************/
+
+#include "RenderQueue.h"
+#include "InstanceBatch.h"
+#include "RenderStats.h"
+#include "raymath.h"
+
+namespace GameEngine
+{
+
+// Id of a key in an id table, assigning the next free id the first time a key is seen.
+template <typename Table, typename Key>
+static unsigned int FindOrAddId(Table& ids, const Key& key)
+{
+    auto found = ids.find(key);
+    if (found != ids.end())
+    {
+        return found->second;
+    }
+    unsigned int id = (unsigned int)ids.size();
+    ids.emplace(key, id);
+    return id;
+}
+
+RenderQueue::RenderQueue() :
+    nearDistance(0.0f),
+    farDistance(1000.0f),
+    stateChanges(0),
+    ring(nullptr)
+{
+}
+
+void RenderQueue::SetInstanceRing(InstanceRing* ring)
+{
+    this->ring = ring;
+}
+
+void RenderQueue::SetDepthRange(float nearDistance, float farDistance)
+{
+    this->nearDistance = nearDistance;
+    this->farDistance = farDistance;
+}
+
+void RenderQueue::Begin()
+{
+    items.clear();
+    itemMaterials.clear();
+    keys.clear();
+    order.clear();
+}
+
+void RenderQueue::Push(unsigned int layer, const Mesh& mesh, const Material& material, Matrix transform, float depth)
+{
+    MaterialState state = MaterialState::FromMaterial(material);
+    unsigned int shaderId = FindOrAddId(shaderIds, material.shader.id);
+    unsigned int materialId = FindOrAddId(materialIds, state);
+    if (materialId == materialInstancing.size())
+    {
+        // First item with this material, look its shader up once.
+        materialInstancing.push_back(InstanceBatcher::SupportsInstancing(material));
+    }
+    unsigned int meshId = FindOrAddId(meshIds, (const void*)mesh.vertices);
+
+    keys.push_back(MakeKey(layer, shaderId, materialId, meshId, QuantizeDepth(depth)));
+    order.push_back((uint32_t)items.size());
+    items.push_back({ mesh, material, transform });
+    itemMaterials.push_back(materialId);
+}
+
+void RenderQueue::Push(unsigned int layer, RenderModel& model, float depth)
+{
+    Matrix world = model.GetWorldMatrix();
+    const Model& data = model.GetModel();
+    for (int i = 0; i < data.meshCount; i++)
+    {
+        Push(layer, data.meshes[i], model.GetMeshMaterial(i), world, depth);
+    }
+}
+
+void RenderQueue::Push(unsigned int layer, const RenderModel& model, Matrix world, float depth)
+{
+    const Model& data = model.GetModel();
+    Matrix modelWorld = MatrixMultiply(data.transform, world);
+    for (int i = 0; i < data.meshCount; i++)
+    {
+        Push(layer, data.meshes[i], model.GetMeshMaterial(i), modelWorld, depth);
+    }
+}
+
+void RenderQueue::Sort()
+{
+    size_t count = keys.size();
+    if (count < 2) return;
+
+    keyScratch.resize(count);
+    orderScratch.resize(count);
+
+    // One pass per byte, least significant first. Each pass is stable, so earlier passes
+    // decide the order between keys that tie on later bytes.
+    for (int shift = 0; shift < 64; shift += 8)
+    {
+        size_t histogram[256] = { 0 };
+        for (size_t i = 0; i < count; i++)
+        {
+            histogram[(keys[i] >> shift) & 0xFF]++;
+        }
+        // Every key has the same byte here, the pass would not move anything.
+        if (histogram[(keys[0] >> shift) & 0xFF] == count) continue;
+
+        size_t offset = 0;
+        for (int digit = 0; digit < 256; digit++)
+        {
+            size_t digitCount = histogram[digit];
+            histogram[digit] = offset;
+            offset += digitCount;
+        }
+        for (size_t i = 0; i < count; i++)
+        {
+            size_t destination = histogram[(keys[i] >> shift) & 0xFF]++;
+            keyScratch[destination] = keys[i];
+            orderScratch[destination] = order[i];
+        }
+        keys.swap(keyScratch);
+        order.swap(orderScratch);
+    }
+}
+
+uint64_t RenderQueue::MakeKey(unsigned int layer, unsigned int shader, unsigned int material,
+                              unsigned int mesh, unsigned int depth)
+{
+    // Ids past the width of a field wrap around. Such keys may sort next to unrelated state,
+    // which costs a state change but never draws with the wrong data.
+    uint64_t key = (uint64_t)(layer & ((1u << layerBits) - 1));
+    key = (key << shaderBits) | (shader & ((1u << shaderBits) - 1));
+    key = (key << materialBits) | (material & ((1u << materialBits) - 1));
+    key = (key << meshBits) | (mesh & ((1u << meshBits) - 1));
+    key = (key << depthBits) | (depth & ((1u << depthBits) - 1));
+    return key;
+}
+
+int RenderQueue::Submit()
+{
+    // Split the sorted items into runs of equal state first, so every instanced run is
+    // written into the ring before the first draw and the frame uploads once.
+    runs.clear();
+    size_t count = order.size();
+    size_t i = 0;
+    while (i < count)
+    {
+        // Extend the run while draws keep the same mesh and material state.
+        size_t runEnd = i + 1;
+        while ((runEnd < count) && SameState(order[i], order[runEnd]))
+        {
+            runEnd++;
+        }
+
+        InstanceRange range = { nullptr, 0, 0 };
+        if ((ring != nullptr) && (runEnd - i > 1) && materialInstancing[itemMaterials[order[i]]])
+        {
+            range = ring->Allocate((int)(runEnd - i));
+            for (int instance = 0; instance < range.count; instance++)
+            {
+                range.matrices[instance] = items[order[i + instance]].transform;
+            }
+        }
+        runs.push_back({ i, runEnd, range });
+        i = runEnd;
+    }
+
+    const int stateShift = meshBits + depthBits;
+    int drawCalls = 0;
+    stateChanges = 0;
+    for (const DrawRun& run: runs)
+    {
+        const DrawItem& item = items[order[run.first]];
+        if ((run.first == 0) || ((keys[run.first] >> stateShift) != (keys[run.first - 1] >> stateShift)))
+        {
+            stateChanges++;
+        }
+
+        if (run.range.count > 0)
+        {
+            ring->Draw(item.mesh, item.material, run.range);
+            drawCalls++;
+        }
+        else if ((run.end - run.first > 1) && materialInstancing[itemMaterials[order[run.first]]])
+        {
+            // No ring, or it is full this frame.
+            runTransforms.clear();
+            for (size_t index = run.first; index < run.end; index++)
+            {
+                runTransforms.push_back(items[order[index]].transform);
+            }
+            DrawMeshInstancedCounted(item.mesh, item.material, runTransforms.data(), (int)runTransforms.size());
+            drawCalls++;
+        }
+        else
+        {
+            for (size_t index = run.first; index < run.end; index++)
+            {
+                const DrawItem& runItem = items[order[index]];
+                DrawMeshCounted(runItem.mesh, runItem.material, runItem.transform);
+                drawCalls++;
+            }
+        }
+    }
+    return drawCalls;
+}
+
+size_t RenderQueue::GetItemCount() const
+{
+    return items.size();
+}
+
+const DrawItem& RenderQueue::GetSortedItem(size_t index) const
+{
+    return items.at(order.at(index));
+}
+
+uint64_t RenderQueue::GetSortedKey(size_t index) const
+{
+    return keys.at(index);
+}
+
+int RenderQueue::GetStateChangeCount() const
+{
+    return stateChanges;
+}
+
+unsigned int RenderQueue::QuantizeDepth(float depth) const
+{
+    const unsigned int maxDepth = (1u << depthBits) - 1;
+    float range = farDistance - nearDistance;
+    if (range <= 0.0f) return 0;
+    float normalized = Clamp((depth - nearDistance)/range, 0.0f, 1.0f);
+    return (unsigned int)(normalized*maxDepth);
+}
+
+bool RenderQueue::SameState(uint32_t first, uint32_t second) const
+{
+    // Material ids stand for the full MaterialState, every map included.
+    return (items[first].mesh.vertices == items[second].mesh.vertices) &&
+           (items[first].mesh.vaoId == items[second].mesh.vaoId) &&
+           (itemMaterials[first] == itemMaterials[second]);
+}
+
+}
@@ -0,0 +1,129 @@
+/*******************************************************************************************
+*
+*   RenderQueue.h
+*   Definition of a RenderQueue. Every visible mesh emits a 64 bit draw key, packed from
+*   most to least significant as:
+*
+*       layer (4) | shader (10) | material (14) | mesh (16) | depth (20)
+*
+*   Keys are LSD radix sorted each frame and the queue is submitted in key order, so draws
+*   that share state end up next to each other. Runs of the same mesh and material are
+*   collapsed into one instanced draw when the shader supports it.
+*
+*   LICENSE: GPLv3
+*
+*   Copyright (c) 2021 Juniper Dusk (@juniper-dusk)
+*
+*******************************************************************************************/
+
+#ifndef RENDERQUEUE_H
+#define RENDERQUEUE_H
+
+#include "raylib.h"
+#include "InstanceRing.h"
+#include "MaterialState.h"
+#include "RenderModel.h"
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace GameEngine
+{
+
+// One queued mesh draw.
+typedef struct DrawItem
+{
+    Mesh mesh;
+    Material material;
+    Matrix transform;
+} DrawItem;
+
+class RenderQueue
+{
+public:
+    // Bits used by each field of a draw key.
+    static const int layerBits    = 4;
+    static const int shaderBits   = 10;
+    static const int materialBits = 14;
+    static const int meshBits     = 16;
+    static const int depthBits    = 20;
+
+    // INITIALIZATION.
+    RenderQueue();
+    // Disallow copies.
+    RenderQueue(const RenderQueue& copy) = delete;
+
+    // Draw instanced runs from this ring, or with DrawMeshInstanced when null. The ring's
+    // frame must be begun before Submit() and ended after it.
+    void SetInstanceRing(InstanceRing* ring);
+    // Distances mapped onto the depth field, anything outside is clamped.
+    void SetDepthRange(float nearDistance, float farDistance);
+
+    // QUEUE BUILDING.
+    // Start a new frame. Keeps storage and the shader/material/mesh ids from earlier frames.
+    void Begin();
+    // Queue one mesh. Depth is the distance from the viewer, nearer draws first within a state.
+    void Push(unsigned int layer, const Mesh& mesh, const Material& material, Matrix transform, float depth);
+    // Queue every mesh of a model, at the model's cached world matrix.
+    void Push(unsigned int layer, RenderModel& model, float depth);
+    // Queue every mesh of a model at an explicit world matrix, such as an interpolated one.
+    void Push(unsigned int layer, const RenderModel& model, Matrix world, float depth);
+
+    // SORTING.
+    // Radix sort the queued keys.
+    void Sort();
+    static uint64_t MakeKey(unsigned int layer, unsigned int shader, unsigned int material,
+                            unsigned int mesh, unsigned int depth);
+
+    // SUBMISSION.
+    // Draw every queued item in key order. Returns the number of draw calls issued.
+    int Submit();
+
+    // QUERIES.
+    size_t GetItemCount() const;
+    // Queued item in sorted order, valid after Sort().
+    const DrawItem& GetSortedItem(size_t index) const;
+    uint64_t GetSortedKey(size_t index) const;
+    // Shader and material switches made by the last Submit().
+    int GetStateChangeCount() const;
+
+protected:
+    std::vector<DrawItem> items;
+    // Full material id of every item, unlike the key field it never wraps.
+    std::vector<unsigned int> itemMaterials;
+    // Sort keys and item indices, plus scratch buffers for the radix passes.
+    std::vector<uint64_t> keys;
+    std::vector<uint32_t> order;
+    std::vector<uint64_t> keyScratch;
+    std::vector<uint32_t> orderScratch;
+    // Sorted items [first, end) drawn together, with their ring range when instanced.
+    typedef struct DrawRun
+    {
+        size_t first;
+        size_t end;
+        InstanceRange range;
+    } DrawRun;
+    std::vector<DrawRun> runs;
+    // Matrices of one instanced run drawn without the ring.
+    std::vector<Matrix> runTransforms;
+
+    float nearDistance;
+    float farDistance;
+    int stateChanges;
+    InstanceRing* ring;
+
+    // Small integer ids for the state a draw depends on, stable across frames.
+    std::unordered_map<unsigned int, unsigned int> shaderIds;
+    std::unordered_map<MaterialState, unsigned int, MaterialStateHash> materialIds;
+    std::unordered_map<const void*, unsigned int> meshIds;
+    // Whether the shader of every material id reads per-instance matrices.
+    std::vector<bool> materialInstancing;
+
+    unsigned int QuantizeDepth(float depth) const;
+    bool SameState(uint32_t first, uint32_t second) const;
+};
+
+}
+
+#endif // RENDERQUEUE_H
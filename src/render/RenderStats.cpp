@@ -0,0 +1,154 @@
+/*******************************************************************************************
+*
+*   RenderStats.cpp
+*   Implementation of the render counters.
+*
+*   LICENSE: GPLv3
+*
+*   Copyright (c) 2021 Juniper Dusk (@juniper-dusk)
+*
+*******************************************************************************************/
+
+#include "RenderStats.h"
+#include "MaterialState.h"
+#include "raymath.h"
+#include <fstream>
+
+namespace GameEngine
+{
+
+// Counting state, shared by every renderer like raylib's own frame state.
+typedef struct RenderStatsState
+{
+    RenderCounters current;
+    RenderCounters last;
+    MaterialState lastMaterial;
+    bool hasLastMaterial;
+    bool dryRun;
+} RenderStatsState;
+
+static RenderStatsState stats = { };
+
+void DrawMeshCounted(Mesh mesh, Material material, Matrix transform)
+{
+    CountDraw(mesh, material, 1, 1);
+    if (!stats.dryRun) DrawMesh(mesh, material, transform);
+}
+
+void DrawMeshInstancedCounted(Mesh mesh, Material material, Matrix* transforms, int instances)
+{
+    // Instance matrices are uploaded into a fresh buffer on every call.
+    CountDraw(mesh, material, instances, instances);
+    if (!stats.dryRun) DrawMeshInstanced(mesh, material, transforms, instances);
+}
+
+void DrawModelCounted(Model model, Matrix transform)
+{
+    // Same combination DrawModel performs: model transform first, then world.
+    Matrix world = MatrixMultiply(model.transform, transform);
+    for (int i = 0; i < model.meshCount; i++)
+    {
+        DrawMeshCounted(model.meshes[i], model.materials[model.meshMaterial[i]], world);
+    }
+}
+
+void CountDraw(const Mesh& mesh, const Material& material, int instances, int matrixUploads)
+{
+    MaterialState state = MaterialState::FromMaterial(material);
+    if (!stats.hasLastMaterial || (state != stats.lastMaterial))
+    {
+        stats.current.materialSwitches++;
+        stats.lastMaterial = state;
+        stats.hasLastMaterial = true;
+    }
+    stats.current.drawCalls++;
+    stats.current.instances += instances;
+    stats.current.vertices += mesh.vertexCount*instances;
+    stats.current.matrixUploads += matrixUploads;
+}
+
+void CountMatrixUploads(int matrixUploads)
+{
+    stats.current.matrixUploads += matrixUploads;
+}
+
+void CountBatchedDraw(int vertices)
+{
+    stats.current.drawCalls++;
+    stats.current.instances++;
+    stats.current.vertices += vertices;
+}
+
+void BeginRenderStats()
+{
+    stats.last = stats.current;
+    stats.current = { };
+    // Material state does not survive the end of a frame.
+    stats.hasLastMaterial = false;
+}
+
+RenderCounters GetRenderStats()
+{
+    return stats.last;
+}
+
+RenderCounters GetRenderStatsInProgress()
+{
+    return stats.current;
+}
+
+void SetRenderStatsDryRun(bool dryRun)
+{
+    stats.dryRun = dryRun;
+}
+
+void DrawRenderStats(int posX, int posY)
+{
+    // Same font size as DrawFPS.
+    Color color = DARKGREEN;
+    const int fontSize = 20;
+    DrawText(TextFormat("%i draws", stats.last.drawCalls), posX, posY, fontSize, color);
+    DrawText(TextFormat("%i instances", stats.last.instances), posX, posY + fontSize, fontSize, color);
+    DrawText(TextFormat("%i vertices", stats.last.vertices), posX, posY + fontSize*2, fontSize, color);
+    DrawText(TextFormat("%i material switches", stats.last.materialSwitches), posX, posY + fontSize*3, fontSize, color);
+    DrawText(TextFormat("%i matrix uploads", stats.last.matrixUploads), posX, posY + fontSize*4, fontSize, color);
+}
+
+RenderStatsLog::RenderStatsLog()
+{
+}
+
+void RenderStatsLog::Record(const RenderCounters& counters, double frameTime)
+{
+    frames.push_back(counters);
+    frameTimes.push_back(frameTime);
+}
+
+void RenderStatsLog::Clear()
+{
+    frames.clear();
+    frameTimes.clear();
+}
+
+size_t RenderStatsLog::GetFrameCount() const
+{
+    return frames.size();
+}
+
+bool RenderStatsLog::SaveCsv(const std::string& fileName) const
+{
+    std::ofstream file(fileName);
+    if (!file) return false;
+
+    file << "frame,frame_time_us,draw_calls,instances,vertices,material_switches,matrix_uploads\n";
+    for (size_t i = 0; i < frames.size(); i++)
+    {
+        const RenderCounters& counters = frames[i];
+        file << i << ',' << frameTimes[i] << ','
+             << counters.drawCalls << ',' << counters.instances << ',' << counters.vertices << ','
+             << counters.materialSwitches << ',' << counters.matrixUploads << '\n';
+    }
+    return (bool)file;
+}
+
+}
@@ -0,0 +1,88 @@
+/*******************************************************************************************
+*
+*   RenderStats.h
+*   Per frame render counters: draw calls, instances, vertices, material switches and
+*   matrix uploads. Mesh draws go through counted wrappers of the raylib draw functions.
+*   Geometry submitted through rlgl's immediate mode batch, debug lines and HUD text, is
+*   recorded with CountBatchedDraw() as one draw per submission, although raylib may merge
+*   several into one GPU draw. The counters' own overlay is not counted. Counters can be
+*   drawn next to DrawFPS, and a RenderStatsLog collects them per frame for CSV export.
+*
+*   With dry run enabled the wrappers only count, for headless runs without a GL context.
+*
+*   LICENSE: GPLv3
+*
+*   Copyright (c) 2021 Juniper Dusk (@juniper-dusk)
+*
+*******************************************************************************************/
+
+#ifndef RENDERSTATS_H
+#define RENDERSTATS_H
+
+#include "raylib.h"
+#include <string>
+#include <vector>
+
+namespace GameEngine
+{
+
+typedef struct RenderCounters
+{
+    int drawCalls;
+    int instances;
+    int vertices;
+    // Draws whose shader, texture or tint differs from the previous draw.
+    int materialSwitches;
+    // Model matrices sent to the GPU, as uniforms or instance attributes.
+    int matrixUploads;
+} RenderCounters;
+
+// COUNTED DRAWING.
+void DrawMeshCounted(Mesh mesh, Material material, Matrix transform);
+void DrawMeshInstancedCounted(Mesh mesh, Material material, Matrix* transforms, int instances);
+// Draw a model with a world matrix, counting each of its meshes.
+void DrawModelCounted(Model model, Matrix transform);
+// Record a draw issued without the wrappers.
+void CountDraw(const Mesh& mesh, const Material& material, int instances, int matrixUploads);
+void CountMatrixUploads(int matrixUploads);
+// Record vertices submitted through rlgl's immediate mode batch.
+void CountBatchedDraw(int vertices);
+
+// FRAMES.
+// Start counting a new frame. The finished frame stays readable through GetRenderStats().
+void BeginRenderStats();
+// Counters of the last finished frame.
+RenderCounters GetRenderStats();
+// Counters of the frame in progress.
+RenderCounters GetRenderStatsInProgress();
+// Only count draws without issuing them.
+void SetRenderStatsDryRun(bool dryRun);
+// Draw the last finished frame's counters, one line each, like DrawFPS.
+void DrawRenderStats(int posX, int posY);
+
+class RenderStatsLog
+{
+public:
+    // INITIALIZATION.
+    RenderStatsLog();
+    // Disallow copies.
+    RenderStatsLog(const RenderStatsLog& copy) = delete;
+
+    // RECORDING.
+    // Frame time in microseconds.
+    void Record(const RenderCounters& counters, double frameTime);
+    void Clear();
+    size_t GetFrameCount() const;
+
+    // EXPORT.
+    // One row per frame, with a header. Returns false if the file cannot be written.
+    bool SaveCsv(const std::string& fileName) const;
+
+protected:
+    std::vector<RenderCounters> frames;
+    std::vector<double> frameTimes;
+};
+
+}
+
+#endif // RENDERSTATS_H
@@ -0,0 +1,371 @@
+/*******************************************************************************************
+*
+*   StaticBatcher.cpp
+*   Implementation of a StaticBatcher.
+*
+*   LICENSE: GPLv3
+*
+*   Copyright (c) 2021 Juniper Dusk (@juniper-dusk)
+*
+*******************************************************************************************/
+
+#include "StaticBatcher.h"
+#include "MaterialState.h"
+#include "RenderStats.h"
+#include "raymath.h"
+#include <algorithm>
+#include <atomic>
+#include <cfloat>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <thread>
+#include <tuple>
+
+namespace GameEngine
+{
+
+// Geometry of one batch while it is being merged.
+typedef struct BatchBuilder
+{
+    std::vector<float> vertices;
+    std::vector<float> normals;
+    std::vector<float> texcoords;
+    // Only filled when a mesh of the group has them.
+    std::vector<float> tangents;
+    std::vector<unsigned char> colors;
+    std::vector<unsigned short> indices;
+    BoundingBox bounds;
+} BatchBuilder;
+
+// Copy a vector into memory owned by a raylib Mesh, or NULL when empty.
+template <typename T>
+static T* CopyToMeshArray(const std::vector<T>& source)
+{
+    if (source.empty()) return nullptr;
+    T* result = (T*)RL_MALLOC(source.size()*sizeof(T));
+    memcpy(result, source.data(), source.size()*sizeof(T));
+    return result;
+}
+
+static void ResetBuilder(BatchBuilder& builder)
+{
+    builder.vertices.clear();
+    builder.normals.clear();
+    builder.texcoords.clear();
+    builder.tangents.clear();
+    builder.colors.clear();
+    builder.indices.clear();
+    builder.bounds = { { FLT_MAX, FLT_MAX, FLT_MAX }, { -FLT_MAX, -FLT_MAX, -FLT_MAX } };
+}
+
+static void FinishBuilder(BatchBuilder& builder, const Material& material, std::vector<StaticBatch>& output)
+{
+    if (builder.vertices.empty()) return;
+
+    StaticBatch batch = { };
+    batch.mesh.vertexCount = (int)builder.vertices.size()/3;
+    batch.mesh.triangleCount = builder.indices.empty()? batch.mesh.vertexCount/3 : (int)builder.indices.size()/3;
+    batch.mesh.vertices = CopyToMeshArray(builder.vertices);
+    batch.mesh.normals = CopyToMeshArray(builder.normals);
+    batch.mesh.texcoords = CopyToMeshArray(builder.texcoords);
+    batch.mesh.tangents = CopyToMeshArray(builder.tangents);
+    batch.mesh.colors = CopyToMeshArray(builder.colors);
+    batch.mesh.indices = CopyToMeshArray(builder.indices);
+    batch.material = material;
+    batch.bounds = builder.bounds;
+    output.push_back(batch);
+    ResetBuilder(builder);
+}
+
+// World matrices one baked mesh instance is transformed by.
+typedef struct VertexTransform
+{
+    Matrix world;
+    Matrix normals;
+    Matrix tangents;
+    // -1 when the world matrix mirrors.
+    float handedness;
+} VertexTransform;
+
+// Append vertex v of a mesh in world space, with defaults for the attributes it lacks.
+static void AppendVertex(BatchBuilder& builder, const Mesh& mesh, int v, const VertexTransform& transform,
+                         bool hasTangents, bool hasColors)
+{
+    Vector3 vertex = Vector3Transform(
+        { mesh.vertices[v*3], mesh.vertices[v*3 + 1], mesh.vertices[v*3 + 2] }, transform.world);
+    builder.vertices.insert(builder.vertices.end(), { vertex.x, vertex.y, vertex.z });
+    builder.bounds.min = Vector3Min(builder.bounds.min, vertex);
+    builder.bounds.max = Vector3Max(builder.bounds.max, vertex);
+
+    Vector3 normal = { 0.0f, 1.0f, 0.0f };
+    if (mesh.normals)
+    {
+        normal = Vector3Normalize(Vector3Transform(
+            { mesh.normals[v*3], mesh.normals[v*3 + 1], mesh.normals[v*3 + 2] }, transform.normals));
+    }
+    builder.normals.insert(builder.normals.end(), { normal.x, normal.y, normal.z });
+
+    if (mesh.texcoords)
+    {
+        builder.texcoords.insert(builder.texcoords.end(), { mesh.texcoords[v*2], mesh.texcoords[v*2 + 1] });
+    }
+    else
+    {
+        builder.texcoords.insert(builder.texcoords.end(), { 0.0f, 0.0f });
+    }
+
+    if (hasTangents)
+    {
+        Vector3 tangent = { 1.0f, 0.0f, 0.0f };
+        float sign = 1.0f;
+        if (mesh.tangents)
+        {
+            tangent = { mesh.tangents[v*4], mesh.tangents[v*4 + 1], mesh.tangents[v*4 + 2] };
+            sign = mesh.tangents[v*4 + 3];
+        }
+        tangent = Vector3Normalize(Vector3Transform(tangent, transform.tangents));
+        builder.tangents.insert(builder.tangents.end(), { tangent.x, tangent.y, tangent.z, sign*transform.handedness });
+    }
+    if (hasColors)
+    {
+        if (mesh.colors)
+        {
+            builder.colors.insert(builder.colors.end(), &mesh.colors[v*4], &mesh.colors[v*4 + 4]);
+        }
+        else
+        {
+            builder.colors.insert(builder.colors.end(), { 255, 255, 255, 255 });
+        }
+    }
+}
+
+StaticBatcher::StaticBatcher(float chunkSize) :
+    chunkSize(chunkSize)
+{
+}
+
+StaticBatcher::~StaticBatcher()
+{
+    Unload();
+}
+
+void StaticBatcher::Attach(const GameTransform* transform, const RenderModel* model)
+{
+    attachments.emplace(transform, model);
+}
+
+void StaticBatcher::Clear()
+{
+    attachments.clear();
+}
+
+int StaticBatcher::Bake(const GameTransform& root, bool upload)
+{
+    Unload();
+
+    // Gather instances per (chunk, material), walking only through static transforms.
+    typedef std::tuple<int, int, int, size_t> GroupKey;
+    std::map<GroupKey, size_t> groupIndices;
+    std::unordered_map<MaterialState, size_t, MaterialStateHash> materialIndices;
+    std::vector<BakeGroup> groups;
+
+    std::vector<const GameTransform*> stack;
+    if (root.IsStatic()) stack.push_back(&root);
+    while (!stack.empty())
+    {
+        const GameTransform* node = stack.back();
+        stack.pop_back();
+
+        Matrix world = node->GetLocalToWorldMatrix();
+        auto range = attachments.equal_range(node);
+        for (auto attachment = range.first; attachment != range.second; attachment++)
+        {
+            const RenderModel* model = attachment->second;
+            const Model& data = model->GetModel();
+            Matrix meshWorld = MatrixMultiply(data.transform, world);
+            Vector3 position = GameTransform::ExtractTranslation(meshWorld);
+            for (int i = 0; i < data.meshCount; i++)
+            {
+                const Material& material = model->GetMeshMaterial(i);
+                MaterialState state = MaterialState::FromMaterial(material);
+                auto materialIndex = materialIndices.emplace(state, materialIndices.size()).first->second;
+                GroupKey key(
+                    (int)floorf(position.x/chunkSize),
+                    (int)floorf(position.y/chunkSize),
+                    (int)floorf(position.z/chunkSize),
+                    materialIndex
+                );
+                auto found = groupIndices.find(key);
+                if (found == groupIndices.end())
+                {
+                    found = groupIndices.emplace(key, groups.size()).first;
+                    groups.push_back({ material, {} });
+                }
+                groups[found->second].instances.push_back({ &data.meshes[i], meshWorld });
+            }
+        }
+        for (const GameTransform* child: node->GetChildren())
+        {
+            if (child->IsStatic()) stack.push_back(child);
+        }
+    }
+
+    // Merge groups in parallel, each worker takes the next unmerged group.
+    std::vector<std::vector<StaticBatch>> results(groups.size());
+    std::atomic<size_t> nextGroup(0);
+    auto worker = [&]() {
+        for (size_t group = nextGroup++; group < groups.size(); group = nextGroup++)
+        {
+            MergeGroup(groups[group], results[group]);
+        }
+    };
+    size_t threadCount = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()), groups.size());
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < threadCount; i++)
+    {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (std::thread& thread: threads)
+    {
+        thread.join();
+    }
+
+    for (std::vector<StaticBatch>& result: results)
+    {
+        batches.insert(batches.end(), result.begin(), result.end());
+    }
+    // GPU upload has to happen on the thread that owns the GL context.
+    if (upload)
+    {
+        for (StaticBatch& batch: batches)
+        {
+            UploadMesh(&batch.mesh, false);
+        }
+    }
+    return (int)batches.size();
+}
+
+void StaticBatcher::Unload()
+{
+    for (StaticBatch& batch: batches)
+    {
+        if (batch.mesh.vaoId > 0)
+        {
+            UnloadMesh(batch.mesh);
+        }
+        else
+        {
+            // Never uploaded, only CPU memory to free.
+            RL_FREE(batch.mesh.vertices);
+            RL_FREE(batch.mesh.normals);
+            RL_FREE(batch.mesh.texcoords);
+            RL_FREE(batch.mesh.tangents);
+            RL_FREE(batch.mesh.colors);
+            RL_FREE(batch.mesh.indices);
+        }
+    }
+    batches.clear();
+}
+
+size_t StaticBatcher::GetBatchCount() const
+{
+    return batches.size();
+}
+
+const StaticBatch& StaticBatcher::GetBatch(size_t index) const
+{
+    return batches.at(index);
+}
+
+int StaticBatcher::Draw() const
+{
+    for (const StaticBatch& batch: batches)
+    {
+        DrawMeshCounted(batch.mesh, batch.material, MatrixIdentity());
+    }
+    return (int)batches.size();
+}
+
+void StaticBatcher::MergeGroup(const BakeGroup& group, std::vector<StaticBatch>& output)
+{
+    BatchBuilder builder;
+    ResetBuilder(builder);
+
+    // Meshes without tangents or colors get defaults when others in the group have them.
+    bool hasTangents = false;
+    bool hasColors = false;
+    for (const BakeInstance& instance: group.instances)
+    {
+        hasTangents = hasTangents || (instance.mesh->tangents != nullptr);
+        hasColors = hasColors || (instance.mesh->colors != nullptr);
+    }
+
+    for (const BakeInstance& instance: group.instances)
+    {
+        const Mesh& mesh = *instance.mesh;
+        if (!mesh.vertices || (mesh.vertexCount <= 0)) continue;
+
+        // Start a new batch when this mesh would overflow 16 bit indices, or is too large to
+        // be indexed at all.
+        bool indexed = (mesh.vertexCount <= maxBatchVertices);
+        if (!indexed || ((int)builder.vertices.size()/3 + mesh.vertexCount > maxBatchVertices))
+        {
+            FinishBuilder(builder, group.material, output);
+        }
+
+        // Normals go through the inverse transpose, so non-uniform scale keeps them correct.
+        VertexTransform transform;
+        transform.world = instance.world;
+        transform.normals = MatrixTranspose(MatrixInvert(instance.world));
+        transform.normals.m12 = 0.0f;
+        transform.normals.m13 = 0.0f;
+        transform.normals.m14 = 0.0f;
+        // Tangents follow the surface like positions, without the translation. A mirroring
+        // transform flips the bitangent, which the sign in w carries.
+        transform.tangents = instance.world;
+        transform.tangents.m12 = 0.0f;
+        transform.tangents.m13 = 0.0f;
+        transform.tangents.m14 = 0.0f;
+        transform.handedness = (MatrixDeterminant(instance.world) < 0.0f)? -1.0f : 1.0f;
+
+        if (!indexed)
+        {
+            // Too large for 16 bit indices on its own: expand it into a triangle list and
+            // emit it unindexed in a batch of its own.
+            int cornerCount = mesh.indices? mesh.triangleCount*3 : mesh.vertexCount;
+            for (int i = 0; i < cornerCount; i++)
+            {
+                AppendVertex(builder, mesh, mesh.indices? mesh.indices[i] : i, transform, hasTangents, hasColors);
+            }
+            FinishBuilder(builder, group.material, output);
+            continue;
+        }
+
+        unsigned short base = (unsigned short)(builder.vertices.size()/3);
+        for (int v = 0; v < mesh.vertexCount; v++)
+        {
+            AppendVertex(builder, mesh, v, transform, hasTangents, hasColors);
+        }
+        if (mesh.indices)
+        {
+            for (int i = 0; i < mesh.triangleCount*3; i++)
+            {
+                builder.indices.push_back((unsigned short)(base + mesh.indices[i]));
+            }
+        }
+        else
+        {
+            // Unindexed triangle list, every vertex is used once in order.
+            for (int i = 0; i < mesh.vertexCount; i++)
+            {
+                builder.indices.push_back((unsigned short)(base + i));
+            }
+        }
+    }
+    FinishBuilder(builder, group.material, output);
+}
+
+}
@@ -0,0 +1,99 @@
+/*******************************************************************************************
+*
+*   StaticBatcher.h
+*   Definition of a StaticBatcher. Bakes the models hanging under static transforms into a
+*   few combined meshes: meshes that share a material are merged, with their vertices
+*   pre-transformed by their world matrices. Normals, texture coordinates, tangents and
+*   vertex colors are carried over; when only some meshes of a batch have tangents or
+*   colors, the rest get a default tangent and white. Merging is split into spatial chunks, so every
+*   batch keeps a bounding box small enough to be culled, and chunks are merged in parallel.
+*
+*   Batches hold copies of the attached models' materials; the RenderModels must outlive
+*   the batches. Baked models should no longer be drawn individually.
+*
+*   LICENSE: GPLv3
+*
+*   Copyright (c) 2021 Juniper Dusk (@juniper-dusk)
+*
+*******************************************************************************************/
+
+#ifndef STATICBATCHER_H
+#define STATICBATCHER_H
+
+#include "raylib.h"
+#include "RenderModel.h"
+#include <transform/GameTransform.h>
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
+
+namespace GameEngine
+{
+
+// One merged mesh, in world space.
+typedef struct StaticBatch
+{
+    Mesh mesh;
+    Material material;
+    BoundingBox bounds;
+} StaticBatch;
+
+class StaticBatcher
+{
+public:
+    // Meshes use 16 bit indices, so a batch addresses at most 65536 vertices. Larger chunks
+    // are split over several batches; a mesh larger on its own becomes an unindexed
+    // triangle list.
+    static const int maxBatchVertices = 65536;
+
+    // INITIALIZATION.
+    // Chunks are cubes of chunkSize world units.
+    StaticBatcher(float chunkSize = 32.0f);
+    // Disallow copies.
+    StaticBatcher(const StaticBatcher& copy) = delete;
+    virtual ~StaticBatcher();
+
+    // ATTACHMENTS.
+    void Attach(const GameTransform* transform, const RenderModel* model);
+    void Clear();
+
+    // BAKING.
+    // Merge the models attached to root and its static descendants. Descent stops at
+    // transforms that are not static. Upload sends the batches to the GPU; leave it off
+    // to bake without a GL context. Returns the number of batches.
+    int Bake(const GameTransform& root, bool upload = true);
+    // Free every baked batch.
+    void Unload();
+
+    // QUERIES.
+    size_t GetBatchCount() const;
+    const StaticBatch& GetBatch(size_t index) const;
+
+    // DRAWING.
+    // Draw every batch. Returns the number of draw calls issued.
+    int Draw() const;
+
+protected:
+    // A mesh to merge and the matrix that takes it to world space.
+    typedef struct BakeInstance
+    {
+        const Mesh* mesh;
+        Matrix world;
+    } BakeInstance;
+    // Instances that share a chunk and a material.
+    typedef struct BakeGroup
+    {
+        Material material;
+        std::vector<BakeInstance> instances;
+    } BakeGroup;
+
+    float chunkSize;
+    std::unordered_multimap<const GameTransform*, const RenderModel*> attachments;
+    std::vector<StaticBatch> batches;
+
+    static void MergeGroup(const BakeGroup& group, std::vector<StaticBatch>& output);
+};
+
+}
+
+#endif // STATICBATCHER_H
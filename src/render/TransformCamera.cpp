@@ -0,0 +1,197 @@
+/*******************************************************************************************
+*
+*   TransformCamera.cpp
+*   Implementation of a TransformCamera.
+*
+*   LICENSE: GPLv3
+*
+*   Copyright (c) 2021 Juniper Dusk (@juniper-dusk)
+*
+*******************************************************************************************/
+
+#include "TransformCamera.h"
+#include "raymath.h"
+#include "rlgl.h"
+#include <cmath>
+
+namespace GameEngine
+{
+
+TransformCamera::TransformCamera(const GameTransform* transform, float fovy, float nearPlane, float farPlane) :
+    transform(transform),
+    projectionType(CAMERA_PERSPECTIVE),
+    fovy(fovy),
+    nearPlane(nearPlane),
+    farPlane(farPlane),
+    aspect(1.0f),
+    view(MatrixIdentity()),
+    projection(MatrixIdentity()),
+    viewProjection(MatrixIdentity()),
+    frustum({ }),
+    viewVersion(0),
+    viewDirty(true),
+    projectionDirty(true)
+{
+}
+
+const GameTransform* TransformCamera::GetTransform() const
+{
+    return transform;
+}
+
+void TransformCamera::SetTransform(const GameTransform* transform)
+{
+    this->transform = transform;
+    viewDirty = true;
+}
+
+void TransformCamera::SetPerspective(float fovy, float nearPlane, float farPlane)
+{
+    projectionType = CAMERA_PERSPECTIVE;
+    this->fovy = fovy;
+    this->nearPlane = nearPlane;
+    this->farPlane = farPlane;
+    projectionDirty = true;
+}
+
+void TransformCamera::SetOrthographic(float height, float nearPlane, float farPlane)
+{
+    projectionType = CAMERA_ORTHOGRAPHIC;
+    this->fovy = height;
+    this->nearPlane = nearPlane;
+    this->farPlane = farPlane;
+    projectionDirty = true;
+}
+
+int TransformCamera::GetProjectionType() const
+{
+    return projectionType;
+}
+
+float TransformCamera::GetAspect() const
+{
+    return aspect;
+}
+
+void TransformCamera::SetAspect(float aspect)
+{
+    if (aspect == this->aspect) return;
+    this->aspect = aspect;
+    projectionDirty = true;
+}
+
+Vector3 TransformCamera::GetPosition() const
+{
+    return GameTransform::ExtractTranslation(transform->GetLocalToWorldMatrix());
+}
+
+Matrix TransformCamera::GetViewMatrix() const
+{
+    Refresh();
+    return view;
+}
+
+Matrix TransformCamera::GetProjectionMatrix() const
+{
+    Refresh();
+    return projection;
+}
+
+Matrix TransformCamera::GetViewProjectionMatrix() const
+{
+    Refresh();
+    return viewProjection;
+}
+
+const Frustum& TransformCamera::GetFrustum() const
+{
+    Refresh();
+    return frustum;
+}
+
+Frustum TransformCamera::ExtractFrustum(Matrix viewProjection)
+{
+    // Clip space is -w <= x, y, z <= w; each plane is the last row plus or minus another.
+    const Matrix& m = viewProjection;
+    Vector4 rows[4] = {
+        { m.m0, m.m4, m.m8, m.m12 },
+        { m.m1, m.m5, m.m9, m.m13 },
+        { m.m2, m.m6, m.m10, m.m14 },
+        { m.m3, m.m7, m.m11, m.m15 }
+    };
+    Frustum result;
+    for (int axis = 0; axis < 3; axis++)
+    {
+        for (int side = 0; side < 2; side++)
+        {
+            float sign = (side == 0)? 1.0f : -1.0f;
+            Vector4 plane = {
+                rows[3].x + sign*rows[axis].x,
+                rows[3].y + sign*rows[axis].y,
+                rows[3].z + sign*rows[axis].z,
+                rows[3].w + sign*rows[axis].w
+            };
+            // Unit normals, so plane distances are in world units.
+            float length = sqrtf(plane.x*plane.x + plane.y*plane.y + plane.z*plane.z);
+            if (length > 0.0f)
+            {
+                plane = { plane.x/length, plane.y/length, plane.z/length, plane.w/length };
+            }
+            result.planes[axis*2 + side] = plane;
+        }
+    }
+    return result;
+}
+
+void TransformCamera::Begin()
+{
+    SetAspect((float)GetScreenWidth()/(float)GetScreenHeight());
+    Refresh();
+
+    // Same state BeginMode3D sets up, so EndMode3D can undo it.
+    rlDrawRenderBatchActive();
+    rlMatrixMode(RL_PROJECTION);
+    rlPushMatrix();
+    rlLoadIdentity();
+    rlMultMatrixf(MatrixToFloat(projection));
+    rlMatrixMode(RL_MODELVIEW);
+    rlLoadIdentity();
+    rlMultMatrixf(MatrixToFloat(view));
+    rlEnableDepthTest();
+}
+
+void TransformCamera::End()
+{
+    EndMode3D();
+}
+
+void TransformCamera::Refresh() const
+{
+    unsigned int version = transform->GetWorldVersion();
+    if (!viewDirty && !projectionDirty && (version == viewVersion)) return;
+
+    if (viewDirty || (version != viewVersion))
+    {
+        view = transform->GetWorldToLocalMatrix();
+        viewVersion = version;
+        viewDirty = false;
+    }
+    if (projectionDirty)
+    {
+        if (projectionType == CAMERA_PERSPECTIVE)
+        {
+            projection = MatrixPerspective(fovy*DEG2RAD, aspect, nearPlane, farPlane);
+        }
+        else
+        {
+            float top = fovy/2.0f;
+            float right = top*aspect;
+            projection = MatrixOrtho(-right, right, -top, top, nearPlane, farPlane);
+        }
+        projectionDirty = false;
+    }
+    viewProjection = MatrixMultiply(view, projection);
+    frustum = ExtractFrustum(viewProjection);
+}
+
+}
@@ -0,0 +1,91 @@
+/*******************************************************************************************
+*
+*   TransformCamera.h
+*   Definition of a TransformCamera. A camera mounted on a GameTransform, looking down the
+*   transform's local -Z axis with +Y up. The view matrix is the transform's world to local
+*   matrix, rebuilt only when the transform's world version changes; the view-projection
+*   matrix and frustum planes are cached alongside it. Mount it anywhere in a hierarchy to
+*   make it follow a rig, a vehicle or a cutscene path.
+*
+*   LICENSE: GPLv3
+*
+*   Copyright (c) 2021 Juniper Dusk (@juniper-dusk)
+*
+*******************************************************************************************/
+
+#ifndef TRANSFORMCAMERA_H
+#define TRANSFORMCAMERA_H
+
+#include "raylib.h"
+#include <transform/GameTransform.h>
+
+namespace GameEngine
+{
+
+// Planes of a view volume as (a, b, c, d), pointing inwards: a point is inside a plane
+// when a*x + b*y + c*z + d >= 0. Ordered left, right, bottom, top, near, far.
+typedef struct Frustum
+{
+    Vector4 planes[6];
+} Frustum;
+
+class TransformCamera
+{
+public:
+    // INITIALIZATION.
+    // Perspective camera with a vertical field of view in degrees.
+    TransformCamera(const GameTransform* transform, float fovy = 45.0f, float nearPlane = 0.01f, float farPlane = 1000.0f);
+    // Disallow copies.
+    TransformCamera(const TransformCamera& copy) = delete;
+
+    // MOUNT PROPERTY.
+    const GameTransform* GetTransform() const;
+    void SetTransform(const GameTransform* transform);
+
+    // PROJECTION PROPERTIES.
+    // Vertical field of view in degrees.
+    void SetPerspective(float fovy, float nearPlane, float farPlane);
+    // Height of the view volume in world units.
+    void SetOrthographic(float height, float nearPlane, float farPlane);
+    int GetProjectionType() const;
+    // Width over height. Begin() keeps it in sync with the screen.
+    float GetAspect() const;
+    void SetAspect(float aspect);
+
+    // QUERIES.
+    Vector3 GetPosition() const;
+    Matrix GetViewMatrix() const;
+    Matrix GetProjectionMatrix() const;
+    Matrix GetViewProjectionMatrix() const;
+    const Frustum& GetFrustum() const;
+    // Frustum planes of any view-projection matrix.
+    static Frustum ExtractFrustum(Matrix viewProjection);
+
+    // DRAWING.
+    // Replacements for BeginMode3D/EndMode3D, loading the cached matrices.
+    void Begin();
+    void End();
+
+protected:
+    const GameTransform* transform;
+    int projectionType;
+    float fovy;
+    float nearPlane;
+    float farPlane;
+    float aspect;
+
+    // Caches, rebuilt when the mount moves or the projection changes.
+    mutable Matrix view;
+    mutable Matrix projection;
+    mutable Matrix viewProjection;
+    mutable Frustum frustum;
+    mutable unsigned int viewVersion;
+    mutable bool viewDirty;
+    mutable bool projectionDirty;
+
+    void Refresh() const;
+};
+
+}
+
+#endif // TRANSFORMCAMERA_H
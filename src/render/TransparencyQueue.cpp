@@ -0,0 +1,183 @@
+/*******************************************************************************************
+*
+*   TransparencyQueue.cpp
+*   Implementation of a TransparencyQueue.
+*
+*   LICENSE: GPLv3
+*
+*   Copyright (c) 2021 Juniper Dusk (@juniper-dusk)
+*
+*******************************************************************************************/
+
+#include "TransparencyQueue.h"
+#include "RenderStats.h"
+#include "raymath.h"
+#include <cstring>
+
+namespace GameEngine
+{
+
+TransparencyQueue::TransparencyQueue() :
+    frameCoherent(false),
+    viewRow({ 0.0f, 0.0f, 1.0f, 0.0f })
+{
+}
+
+bool TransparencyQueue::IsFrameCoherent() const
+{
+    return frameCoherent;
+}
+
+void TransparencyQueue::SetFrameCoherent(bool frameCoherent)
+{
+    this->frameCoherent = frameCoherent;
+}
+
+void TransparencyQueue::Begin(Matrix view)
+{
+    viewRow = { view.m2, view.m6, view.m10, view.m14 };
+    items.clear();
+    depths.clear();
+    keys.clear();
+}
+
+void TransparencyQueue::Push(const Mesh& mesh, const Material& material, Matrix transform)
+{
+    // View space looks down -Z, so depth is the negated view space z of the origin.
+    float depth = -(viewRow.x*transform.m12 + viewRow.y*transform.m13 + viewRow.z*transform.m14 + viewRow.w);
+    items.push_back({ mesh, material, transform });
+    depths.push_back(depth);
+    // Complemented, so the farthest draw gets the smallest key.
+    keys.push_back(~FloatToKey(depth));
+}
+
+void TransparencyQueue::Push(RenderModel& model)
+{
+    Matrix world = model.GetWorldMatrix();
+    const Model& data = model.GetModel();
+    for (int i = 0; i < data.meshCount; i++)
+    {
+        Push(data.meshes[i], model.GetMeshMaterial(i), world);
+    }
+}
+
+void TransparencyQueue::Sort()
+{
+    size_t count = keys.size();
+    // Reuse last frame's order only if the draws can be the same ones.
+    if (frameCoherent && (order.size() == count))
+    {
+        sortedKeys.resize(count);
+        for (size_t i = 0; i < count; i++)
+        {
+            sortedKeys[i] = keys[order[i]];
+        }
+        // A nearly sorted order is repaired in a few moves, give up past that.
+        if (InsertionSort(count*4)) return;
+    }
+    RadixSort();
+}
+
+uint32_t TransparencyQueue::FloatToKey(float value)
+{
+    uint32_t bits = 0;
+    memcpy(&bits, &value, sizeof(bits));
+    // Negative floats sort backwards as integers, flip them entirely. Positive ones only
+    // need the sign bit set to land above every negative one.
+    return (bits & 0x80000000u)? ~bits : (bits | 0x80000000u);
+}
+
+int TransparencyQueue::Submit()
+{
+    for (uint32_t index: order)
+    {
+        const DrawItem& item = items[index];
+        DrawMeshCounted(item.mesh, item.material, item.transform);
+    }
+    return (int)order.size();
+}
+
+size_t TransparencyQueue::GetItemCount() const
+{
+    return items.size();
+}
+
+const DrawItem& TransparencyQueue::GetSortedItem(size_t index) const
+{
+    return items.at(order.at(index));
+}
+
+float TransparencyQueue::GetSortedDepth(size_t index) const
+{
+    return depths.at(order.at(index));
+}
+
+void TransparencyQueue::RadixSort()
+{
+    size_t count = keys.size();
+    order.resize(count);
+    sortedKeys.assign(keys.begin(), keys.end());
+    for (size_t i = 0; i < count; i++)
+    {
+        order[i] = (uint32_t)i;
+    }
+    if (count < 2) return;
+
+    orderScratch.resize(count);
+    keyScratch.resize(count);
+    for (int shift = 0; shift < 32; shift += 8)
+    {
+        size_t histogram[256] = { 0 };
+        for (size_t i = 0; i < count; i++)
+        {
+            histogram[(sortedKeys[i] >> shift) & 0xFF]++;
+        }
+        // Every key has the same byte here, the pass would not move anything.
+        if (histogram[(sortedKeys[0] >> shift) & 0xFF] == count) continue;
+
+        size_t offset = 0;
+        for (int digit = 0; digit < 256; digit++)
+        {
+            size_t digitCount = histogram[digit];
+            histogram[digit] = offset;
+            offset += digitCount;
+        }
+        for (size_t i = 0; i < count; i++)
+        {
+            size_t destination = histogram[(sortedKeys[i] >> shift) & 0xFF]++;
+            keyScratch[destination] = sortedKeys[i];
+            orderScratch[destination] = order[i];
+        }
+        sortedKeys.swap(keyScratch);
+        order.swap(orderScratch);
+    }
+}
+
+bool TransparencyQueue::InsertionSort(size_t maxMoves)
+{
+    size_t moves = 0;
+    for (size_t i = 1; i < sortedKeys.size(); i++)
+    {
+        uint32_t key = sortedKeys[i];
+        uint32_t index = order[i];
+        size_t j = i;
+        while ((j > 0) && (sortedKeys[j - 1] > key))
+        {
+            sortedKeys[j] = sortedKeys[j - 1];
+            order[j] = order[j - 1];
+            j--;
+            // Leaves a valid permutation behind, RadixSort starts over from push order.
+            if (++moves > maxMoves)
+            {
+                sortedKeys[j] = key;
+                order[j] = index;
+                return false;
+            }
+        }
+        sortedKeys[j] = key;
+        order[j] = index;
+    }
+    return true;
+}
+
+}
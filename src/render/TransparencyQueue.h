@@ -0,0 +1,85 @@
+/*******************************************************************************************
+*
+*   TransparencyQueue.h
+*   Definition of a TransparencyQueue. Transparent draws are sorted back to front by their
+*   view space depth, computed once per draw from its cached world matrix. Depths are turned
+*   into order preserving integer keys and radix sorted; when the same draws are queued in
+*   the same order every frame, last frame's order can be repaired with an insertion sort
+*   instead.
+*
+*   LICENSE: GPLv3
+*
+*   Copyright (c) 2021 Juniper Dusk (@juniper-dusk)
+*
+*******************************************************************************************/
+
+#ifndef TRANSPARENCYQUEUE_H
+#define TRANSPARENCYQUEUE_H
+
+#include "raylib.h"
+#include "RenderModel.h"
+#include "RenderQueue.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace GameEngine
+{
+
+class TransparencyQueue
+{
+public:
+    // INITIALIZATION.
+    TransparencyQueue();
+    // Disallow copies.
+    TransparencyQueue(const TransparencyQueue& copy) = delete;
+
+    // FRAME COHERENCE PROPERTY.
+    // Start from last frame's order when the queue has the same size as last frame.
+    // Only worth enabling when draws are pushed in a stable order every frame.
+    bool IsFrameCoherent() const;
+    void SetFrameCoherent(bool frameCoherent);
+
+    // QUEUE BUILDING.
+    // Start a new frame seen through the given view matrix.
+    void Begin(Matrix view);
+    void Push(const Mesh& mesh, const Material& material, Matrix transform);
+    void Push(RenderModel& model);
+
+    // SORTING.
+    // Order draws back to front.
+    void Sort();
+    // Order preserving unsigned key for a float, larger floats give larger keys.
+    static uint32_t FloatToKey(float value);
+
+    // SUBMISSION.
+    // Draw every queued item back to front. Returns the number of draw calls issued.
+    int Submit();
+
+    // QUERIES.
+    size_t GetItemCount() const;
+    const DrawItem& GetSortedItem(size_t index) const;
+    float GetSortedDepth(size_t index) const;
+
+protected:
+    bool frameCoherent;
+    // Third row of the view matrix, gives view space z in one dot product.
+    Vector4 viewRow;
+
+    std::vector<DrawItem> items;
+    std::vector<float> depths;
+    // Depth keys in push order, complemented so ascending order is back to front.
+    std::vector<uint32_t> keys;
+    std::vector<uint32_t> order;
+    std::vector<uint32_t> orderScratch;
+    std::vector<uint32_t> sortedKeys;
+    std::vector<uint32_t> keyScratch;
+
+    void RadixSort();
+    // Returns false and gives up when the order is too far from sorted.
+    bool InsertionSort(size_t maxMoves);
+};
+
+}
+
+#endif // TRANSPARENCYQUEUE_H
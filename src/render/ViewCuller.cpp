@@ -0,0 +1,125 @@
+/*******************************************************************************************
+*
+*   ViewCuller.cpp
+*   Implementation of a ViewCuller.
+*
+*   LICENSE: GPLv3
+*
+*   Copyright (c) 2021 Juniper Dusk (@juniper-dusk)
+*
+*******************************************************************************************/
+
+#include "ViewCuller.h"
+#include "raymath.h"
+#include <algorithm>
+#include <cmath>
+
+namespace GameEngine
+{
+
+ViewCuller::ViewCuller() :
+    viewCount(0)
+{
+}
+
+size_t ViewCuller::Add(const GameTransform* transform, BoundingBox localBounds)
+{
+    Vector3 center = Vector3Scale(Vector3Add(localBounds.min, localBounds.max), 0.5f);
+    transforms.push_back(transform);
+    localCenters.push_back(center);
+    localRadii.push_back(Vector3Distance(center, localBounds.max));
+    worldCenters.push_back(center);
+    worldRadii.push_back(0.0f);
+    // Forces a refresh on the first cull.
+    versions.push_back(transform->GetWorldVersion() - 1);
+    masks.push_back(0);
+    return transforms.size() - 1;
+}
+
+void ViewCuller::Clear()
+{
+    transforms.clear();
+    localCenters.clear();
+    localRadii.clear();
+    worldCenters.clear();
+    worldRadii.clear();
+    versions.clear();
+    masks.clear();
+}
+
+size_t ViewCuller::GetObjectCount() const
+{
+    return transforms.size();
+}
+
+void ViewCuller::ClearViews()
+{
+    viewCount = 0;
+}
+
+int ViewCuller::AddView(const Frustum& frustum)
+{
+    if (viewCount >= maxViews) return -1;
+    views[viewCount] = frustum;
+    return viewCount++;
+}
+
+int ViewCuller::GetViewCount() const
+{
+    return viewCount;
+}
+
+void ViewCuller::Cull()
+{
+    for (size_t i = 0; i < transforms.size(); i++)
+    {
+        unsigned int version = transforms[i]->GetWorldVersion();
+        if (version != versions[i])
+        {
+            // Largest axis scale keeps the sphere conservative under non-uniform scale.
+            Matrix world = transforms[i]->GetLocalToWorldMatrix();
+            Vector3 scale = GameTransform::ExtractScale(world);
+            worldCenters[i] = Vector3Transform(localCenters[i], world);
+            worldRadii[i] = localRadii[i]*std::max(fabsf(scale.x), std::max(fabsf(scale.y), fabsf(scale.z)));
+            versions[i] = version;
+        }
+
+        Vector3 center = worldCenters[i];
+        float radius = worldRadii[i];
+        uint8_t mask = 0;
+        for (int view = 0; view < viewCount; view++)
+        {
+            const Vector4* planes = views[view].planes;
+            bool inside = true;
+            for (int plane = 0; (plane < 6) && inside; plane++)
+            {
+                inside = (planes[plane].x*center.x + planes[plane].y*center.y + planes[plane].z*center.z + planes[plane].w >= -radius);
+            }
+            if (inside) mask |= (uint8_t)(1 << view);
+        }
+        masks[i] = mask;
+    }
+}
+
+uint8_t ViewCuller::GetMask(size_t index) const
+{
+    return masks.at(index);
+}
+
+const std::vector<uint8_t>& ViewCuller::GetMasks() const
+{
+    return masks;
+}
+
+size_t ViewCuller::GetVisible(int view, std::vector<size_t>& visible) const
+{
+    visible.clear();
+    uint8_t bit = (uint8_t)(1 << view);
+    for (size_t i = 0; i < masks.size(); i++)
+    {
+        if (masks[i] & bit) visible.push_back(i);
+    }
+    return visible.size();
+}
+
+}
@@ -0,0 +1,78 @@
+/*******************************************************************************************
+*
+*   ViewCuller.h
+*   Definition of a ViewCuller. Culls every registered object against up to eight view
+*   frustums (camera, shadow cascades, reflections) in a single pass. Each object's world
+*   bounding sphere is refreshed once, only when its transform moved, and then tested
+*   against every view, setting one bit per view it is visible in. A view's draw list is a
+*   filter over those masks, so an extra view costs its plane tests and nothing more.
+*
+*   LICENSE: GPLv3
+*
+*   Copyright (c) 2021 Juniper Dusk (@juniper-dusk)
+*
+*******************************************************************************************/
+
+#ifndef VIEWCULLER_H
+#define VIEWCULLER_H
+
+#include "raylib.h"
+#include "TransformCamera.h"
+#include <transform/GameTransform.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace GameEngine
+{
+
+class ViewCuller
+{
+public:
+    // One bit per view in a visibility mask.
+    static const int maxViews = 8;
+
+    // INITIALIZATION.
+    ViewCuller();
+    // Disallow copies.
+    ViewCuller(const ViewCuller& copy) = delete;
+
+    // OBJECTS.
+    // Register bounds in the transform's local space. Returns the object's index.
+    size_t Add(const GameTransform* transform, BoundingBox localBounds);
+    void Clear();
+    size_t GetObjectCount() const;
+
+    // VIEWS.
+    void ClearViews();
+    // Returns the view's bit index, or -1 when every view is taken.
+    int AddView(const Frustum& frustum);
+    int GetViewCount() const;
+
+    // CULLING.
+    // Test every object against every view.
+    void Cull();
+    // Bit n is set when the object is visible in view n.
+    uint8_t GetMask(size_t index) const;
+    const std::vector<uint8_t>& GetMasks() const;
+    // Indices of the objects visible in a view, in registration order. Returns the count.
+    size_t GetVisible(int view, std::vector<size_t>& visible) const;
+
+protected:
+    std::vector<const GameTransform*> transforms;
+    // Local bounding spheres.
+    std::vector<Vector3> localCenters;
+    std::vector<float> localRadii;
+    // World bounding spheres, with the world version they were built from.
+    std::vector<Vector3> worldCenters;
+    std::vector<float> worldRadii;
+    std::vector<unsigned int> versions;
+    std::vector<uint8_t> masks;
+
+    Frustum views[maxViews];
+    int viewCount;
+};
+
+}
+
+#endif // VIEWCULLER_H
@@ -0,0 +1,336 @@
+/*******************************************************************************************
+*
+*   ConstraintSystem.cpp
+*   Implementation of a ConstraintSystem.
+*
+*   LICENSE: GPLv3
+*
+*   Copyright (c) 2021 Juniper Dusk (@juniper-dusk)
+*
+*******************************************************************************************/
+
+#include "ConstraintSystem.h"
+#include "raymath.h"
+#include <cmath>
+#include <unordered_map>
+
+namespace GameEngine
+{
+
+static WorldPose DecomposeWorld(Matrix world)
+{
+    return {
+        GameTransform::ExtractTranslation(world),
+        QuaternionFromMatrix(GameTransform::ExtractRotation(world)),
+        GameTransform::ExtractScale(world)
+    };
+}
+
+static Vector3 DivideSafe(Vector3 value, Vector3 divisor)
+{
+    return {
+        (divisor.x != 0.0f)? value.x/divisor.x : value.x,
+        (divisor.y != 0.0f)? value.y/divisor.y : value.y,
+        (divisor.z != 0.0f)? value.z/divisor.z : value.z
+    };
+}
+
+ConstraintSystem::ConstraintSystem() :
+    orderDirty(false),
+    cycle(false),
+    cachedParent(nullptr),
+    cachedParentVersion(0)
+{
+}
+
+int ConstraintSystem::AddLookAt(GameTransform* owner, const GameTransform* source, Vector3 forward, Vector3 up)
+{
+    Constraint constraint = NewConstraint(CONSTRAINT_LOOK_AT, owner, source, CONSTRAIN_ROTATION);
+    constraint.forward = Vector3Normalize(forward);
+    constraint.axesInverse = QuaternionInvert(GameTransform::LookRotation(forward, up));
+    return Add(constraint);
+}
+
+int ConstraintSystem::AddAim(GameTransform* owner, const GameTransform* source, Vector3 axis)
+{
+    Constraint constraint = NewConstraint(CONSTRAINT_AIM, owner, source, CONSTRAIN_ROTATION);
+    constraint.forward = Vector3Normalize(axis);
+    return Add(constraint);
+}
+
+int ConstraintSystem::AddCopyTransform(GameTransform* owner, const GameTransform* source, int channels)
+{
+    return Add(NewConstraint(CONSTRAINT_COPY_TRANSFORM, owner, source, channels));
+}
+
+int ConstraintSystem::AddParent(GameTransform* owner, const GameTransform* source, int channels)
+{
+    Constraint constraint = NewConstraint(CONSTRAINT_PARENT, owner, source, channels);
+    // The only inversion: the owner's current pose in the source's space, kept as offset.
+    WorldPose ownerWorld = DecomposeWorld(owner->GetLocalToWorldMatrix());
+    WorldPose sourceWorld = DecomposeWorld(source->GetLocalToWorldMatrix());
+    Quaternion inverseSource = QuaternionInvert(sourceWorld.rotation);
+    constraint.offsetPosition = DivideSafe(Vector3RotateByQuaternion(
+        Vector3Subtract(ownerWorld.position, sourceWorld.position), inverseSource), sourceWorld.scale);
+    constraint.offsetRotation = QuaternionMultiply(inverseSource, ownerWorld.rotation);
+    constraint.offsetScale = DivideSafe(ownerWorld.scale, sourceWorld.scale);
+    return Add(constraint);
+}
+
+void ConstraintSystem::Remove(int id)
+{
+    if (!IsLive(id)) return;
+    constraints[id].owner = nullptr;
+    freeIds.push_back(id);
+    orderDirty = true;
+}
+
+void ConstraintSystem::Clear()
+{
+    constraints.clear();
+    freeIds.clear();
+    order.clear();
+    orderDirty = false;
+    cycle = false;
+}
+
+int ConstraintSystem::GetCount() const
+{
+    return (int)(constraints.size() - freeIds.size());
+}
+
+float ConstraintSystem::GetWeight(int id) const
+{
+    return IsLive(id)? constraints[id].weight : 0.0f;
+}
+
+void ConstraintSystem::SetWeight(int id, float weight)
+{
+    if (!IsLive(id)) return;
+    constraints[id].weight = Clamp(weight, 0.0f, 1.0f);
+}
+
+bool ConstraintSystem::IsEnabled(int id) const
+{
+    return IsLive(id) && constraints[id].enabled;
+}
+
+void ConstraintSystem::SetEnabled(int id, bool enabled)
+{
+    if (!IsLive(id)) return;
+    constraints[id].enabled = enabled;
+}
+
+bool ConstraintSystem::IsLive(int id) const
+{
+    // Removed slots keep their data until reused, but their owner is cleared.
+    return (id >= 0) && (id < (int)constraints.size()) && (constraints[id].owner != nullptr);
+}
+
+void ConstraintSystem::Reorder()
+{
+    orderDirty = true;
+}
+
+const std::vector<int>& ConstraintSystem::GetOrder()
+{
+    if (orderDirty) Sort();
+    return order;
+}
+
+bool ConstraintSystem::HasCycle() const
+{
+    return cycle;
+}
+
+void ConstraintSystem::Evaluate()
+{
+    if (orderDirty) Sort();
+    cachedParent = nullptr;
+    for (int id: order)
+    {
+        Constraint& constraint = constraints[id];
+        if (constraint.enabled && (constraint.weight > 0.0f)) EvaluateConstraint(constraint);
+    }
+}
+
+ConstraintSystem::Constraint ConstraintSystem::NewConstraint(ConstraintType type, GameTransform* owner, const GameTransform* source, int channels)
+{
+    // Enabled at full weight, with neutral axes and offsets until the caller sets them.
+    return {
+        type, owner, source, channels, 1.0f, true,
+        { 0.0f, 0.0f, 1.0f },
+        QuaternionIdentity(),
+        { 0.0f, 0.0f, 0.0f },
+        QuaternionIdentity(),
+        { 1.0f, 1.0f, 1.0f }
+    };
+}
+
+int ConstraintSystem::Add(const Constraint& constraint)
+{
+    int id;
+    if (!freeIds.empty())
+    {
+        id = freeIds.back();
+        freeIds.pop_back();
+        constraints[id] = constraint;
+    }
+    else
+    {
+        id = (int)constraints.size();
+        constraints.push_back(constraint);
+    }
+    orderDirty = true;
+    return id;
+}
+
+void ConstraintSystem::Sort()
+{
+    int count = (int)constraints.size();
+    std::unordered_map<const GameTransform*, std::vector<int>> owned;
+    for (int id = 0; id < count; id++)
+    {
+        if (constraints[id].owner) owned[constraints[id].owner].push_back(id);
+    }
+
+    // A constraint reads its source's world matrix and its owner's parent's. It depends on
+    // every constraint whose owner is one of those or above them.
+    std::vector<std::vector<int>> dependents(count);
+    std::vector<int> pending(count, 0);
+    auto depend = [&](int id, const GameTransform* first) {
+        for (const GameTransform* node = first; node; node = node->GetParent())
+        {
+            auto found = owned.find(node);
+            if (found == owned.end()) continue;
+            for (int other: found->second)
+            {
+                if (other == id) continue;
+                dependents[other].push_back(id);
+                pending[id]++;
+            }
+        }
+    };
+    for (int id = 0; id < count; id++)
+    {
+        const Constraint& constraint = constraints[id];
+        if (!constraint.owner) continue;
+        depend(id, constraint.source);
+        depend(id, constraint.owner->GetParent());
+    }
+
+    // Kahn's algorithm, seeded in id order so independent constraints keep it.
+    order.clear();
+    std::vector<int> ready;
+    for (int id = count - 1; id >= 0; id--)
+    {
+        if (constraints[id].owner && (pending[id] == 0)) ready.push_back(id);
+    }
+    while (!ready.empty())
+    {
+        int id = ready.back();
+        ready.pop_back();
+        order.push_back(id);
+        for (int dependent: dependents[id])
+        {
+            if (--pending[dependent] == 0) ready.push_back(dependent);
+        }
+    }
+
+    cycle = (order.size() < constraints.size() - freeIds.size());
+    if (cycle)
+    {
+        for (int id = 0; id < count; id++)
+        {
+            if (constraints[id].owner && (pending[id] > 0)) order.push_back(id);
+        }
+    }
+    orderDirty = false;
+}
+
+void ConstraintSystem::EvaluateConstraint(Constraint& constraint)
+{
+    GameTransform* owner = constraint.owner;
+    const GameTransform* parent = owner->GetParent();
+    WorldPose parentWorld = { { 0.0f, 0.0f, 0.0f }, QuaternionIdentity(), { 1.0f, 1.0f, 1.0f } };
+    if (parent)
+    {
+        // Siblings are usually constrained together, decompose their parent once.
+        Matrix parentMatrix = parent->GetLocalToWorldMatrix();
+        if ((parent != cachedParent) || (parent->GetWorldVersion() != cachedParentVersion))
+        {
+            cachedParent = parent;
+            cachedParentVersion = parent->GetWorldVersion();
+            cachedParentPose = DecomposeWorld(parentMatrix);
+        }
+        parentWorld = cachedParentPose;
+    }
+    Quaternion inverseParent = QuaternionInvert(parentWorld.rotation);
+
+    Vector3 localPosition = owner->GetLocalPosition();
+    Quaternion localRotation = owner->GetLocalQuaternion();
+    Vector3 localScale = owner->GetLocalScale();
+    Matrix sourceMatrix = constraint.source->GetLocalToWorldMatrix();
+
+    // Solve in world space, then bring back into the owner's parent space.
+    WorldPose world;
+    switch (constraint.type)
+    {
+        case CONSTRAINT_LOOK_AT:
+        case CONSTRAINT_AIM:
+        {
+            Vector3 ownerPosition = Vector3Add(parentWorld.position, Vector3RotateByQuaternion(
+                Vector3Multiply(localPosition, parentWorld.scale), parentWorld.rotation));
+            Vector3 direction = Vector3Subtract(GameTransform::ExtractTranslation(sourceMatrix), ownerPosition);
+            if (Vector3Length(direction) < 0.000001f) return;
+            if (constraint.type == CONSTRAINT_LOOK_AT)
+            {
+                // Target basis times the inverse of the owner's axes basis.
+                world.rotation = QuaternionMultiply(GameTransform::LookRotation(direction, { 0.0f, 1.0f, 0.0f }), constraint.axesInverse);
+            }
+            else
+            {
+                Quaternion current = QuaternionMultiply(parentWorld.rotation, localRotation);
+                Vector3 axis = Vector3RotateByQuaternion(constraint.forward, current);
+                direction = Vector3Normalize(direction);
+                if (Vector3DotProduct(axis, direction) > 0.999999f) return;
+                world.rotation = QuaternionMultiply(QuaternionFromVector3ToVector3(axis, direction), current);
+            }
+            break;
+        }
+        case CONSTRAINT_COPY_TRANSFORM:
+            world = DecomposeWorld(sourceMatrix);
+            break;
+        case CONSTRAINT_PARENT:
+        {
+            WorldPose source = DecomposeWorld(sourceMatrix);
+            world.position = Vector3Add(source.position, Vector3RotateByQuaternion(
+                Vector3Multiply(constraint.offsetPosition, source.scale), source.rotation));
+            world.rotation = QuaternionMultiply(source.rotation, constraint.offsetRotation);
+            world.scale = Vector3Multiply(constraint.offsetScale, source.scale);
+            break;
+        }
+        default:
+            return;
+    }
+
+    float weight = constraint.weight;
+    if (constraint.channels & CONSTRAIN_POSITION)
+    {
+        Vector3 position = DivideSafe(Vector3RotateByQuaternion(
+            Vector3Subtract(world.position, parentWorld.position), inverseParent), parentWorld.scale);
+        owner->SetLocalPosition((weight < 1.0f)? Vector3Lerp(localPosition, position, weight) : position);
+    }
+    if (constraint.channels & CONSTRAIN_ROTATION)
+    {
+        Quaternion rotation = QuaternionNormalize(QuaternionMultiply(inverseParent, world.rotation));
+        owner->SetLocalQuaternion((weight < 1.0f)? QuaternionSlerp(localRotation, rotation, weight) : rotation);
+    }
+    if (constraint.channels & CONSTRAIN_SCALE)
+    {
+        Vector3 scale = DivideSafe(world.scale, parentWorld.scale);
+        owner->SetLocalScale((weight < 1.0f)? Vector3Lerp(localScale, scale, weight) : scale);
+    }
+}
+
+}
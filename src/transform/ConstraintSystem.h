@@ -0,0 +1,137 @@
+/*******************************************************************************************
+*
+*   ConstraintSystem.h
+*   Definition of a ConstraintSystem. Look-at, aim, copy transform and parent constraints
+*   that drive an owner transform from a source transform. Constraints are sorted once so
+*   that every constraint runs after the ones moving its source or the owner's ancestors,
+*   across hierarchies, then evaluated in one pass after animation. A pass reads cached
+*   world matrices, which rebuild only what earlier constraints moved, and writes owners'
+*   local position, rotation and scale without inverting any matrix.
+*
+*   Sorting follows the hierarchy at the time of the last change; call Reorder() after
+*   reparenting anything a constraint depends on. Parents are assumed to have no shear.
+*
+*   LICENSE: GPLv3
+*
+*   Copyright (c) 2021 Juniper Dusk (@juniper-dusk)
+*
+*******************************************************************************************/
+
+#ifndef CONSTRAINTSYSTEM_H
+#define CONSTRAINTSYSTEM_H
+
+#include "raylib.h"
+#include "GameTransform.h"
+#include <vector>
+
+namespace GameEngine
+{
+
+typedef enum ConstraintType
+{
+    // Point an axis at the source, keeping an up axis towards world up.
+    CONSTRAINT_LOOK_AT = 0,
+    // Swing an axis onto the source by the shortest arc, keeping twist.
+    CONSTRAINT_AIM,
+    // Match the source's world position, rotation and scale.
+    CONSTRAINT_COPY_TRANSFORM,
+    // Follow the source as if parented to it, with the offset when added.
+    CONSTRAINT_PARENT
+} ConstraintType;
+
+typedef enum ConstraintChannel
+{
+    CONSTRAIN_POSITION = 1,
+    CONSTRAIN_ROTATION = 2,
+    CONSTRAIN_SCALE = 4,
+    CONSTRAIN_ALL = 7
+} ConstraintChannel;
+
+// A world matrix split into translation, rotation and scale.
+typedef struct WorldPose
+{
+    Vector3 position;
+    Quaternion rotation;
+    Vector3 scale;
+} WorldPose;
+
+class ConstraintSystem
+{
+public:
+    // INITIALIZATION.
+    ConstraintSystem();
+    // Disallow copies.
+    ConstraintSystem(const ConstraintSystem& copy) = delete;
+
+    // CONSTRAINTS.
+    // Each returns the constraint's id. Owners and sources must outlive their constraints.
+    int AddLookAt(GameTransform* owner, const GameTransform* source,
+        Vector3 forward = { 0.0f, 0.0f, 1.0f }, Vector3 up = { 0.0f, 1.0f, 0.0f });
+    int AddAim(GameTransform* owner, const GameTransform* source, Vector3 axis = { 0.0f, 0.0f, 1.0f });
+    int AddCopyTransform(GameTransform* owner, const GameTransform* source, int channels = CONSTRAIN_ALL);
+    int AddParent(GameTransform* owner, const GameTransform* source, int channels = CONSTRAIN_ALL);
+    void Remove(int id);
+    void Clear();
+    int GetCount() const;
+
+    // CONSTRAINT PROPERTIES.
+    // Blend between the owner's own local values (0) and the constrained ones (1).
+    // Removed or unknown ids read as zero weight and disabled, and ignore setters.
+    float GetWeight(int id) const;
+    void SetWeight(int id, float weight);
+    bool IsEnabled(int id) const;
+    void SetEnabled(int id, bool enabled);
+
+    // ORDERING.
+    // Sort again, after the hierarchy changed under constrained transforms.
+    void Reorder();
+    // Constraint ids in evaluation order.
+    const std::vector<int>& GetOrder();
+    // True if the last sort found constraints depending on each other. Those run in the
+    // order they were added, after every other constraint.
+    bool HasCycle() const;
+
+    // EVALUATION.
+    void Evaluate();
+
+protected:
+    typedef struct Constraint
+    {
+        ConstraintType type;
+        // Null for a free slot.
+        GameTransform* owner;
+        const GameTransform* source;
+        int channels;
+        float weight;
+        bool enabled;
+        // Owner axis for look-at and aim.
+        Vector3 forward;
+        // Inverse of the rotation taking x, y, z onto the owner's look-at axes.
+        Quaternion axesInverse;
+        // Owner's world transform in the source's space, for parent constraints.
+        Vector3 offsetPosition;
+        Quaternion offsetRotation;
+        Vector3 offsetScale;
+    } Constraint;
+
+    std::vector<Constraint> constraints;
+    std::vector<int> freeIds;
+    std::vector<int> order;
+    bool orderDirty;
+    bool cycle;
+    // Last owner parent decomposed during Evaluate().
+    const GameTransform* cachedParent;
+    unsigned int cachedParentVersion;
+    WorldPose cachedParentPose;
+
+    static Constraint NewConstraint(ConstraintType type, GameTransform* owner, const GameTransform* source, int channels);
+    int Add(const Constraint& constraint);
+    // Whether id names a constraint that was added and not removed since.
+    bool IsLive(int id) const;
+    void Sort();
+    void EvaluateConstraint(Constraint& constraint);
+};
+
+}
+
+#endif // CONSTRAINTSYSTEM_H
@@ -0,0 +1,301 @@
+/*******************************************************************************************
+*
+*   FixedTimestep.cpp
+*   Implementation of a FixedTimestep scheduler and a TransformInterpolator.
+*
+*   LICENSE: GPLv3
+*
+*   Copyright (c) 2021 Juniper Dusk (@juniper-dusk)
+*
+*******************************************************************************************/
+
+#include "FixedTimestep.h"
+#include "raymath.h"
+#include <algorithm>
+#include <numeric>
+
+namespace GameEngine
+{
+
+FixedTimestep::FixedTimestep(float step, int maxSteps) :
+    step(step),
+    maxSteps(maxSteps),
+    accumulator(0.0f)
+{
+}
+
+int FixedTimestep::Advance(float frameTime)
+{
+    accumulator += frameTime;
+    int steps = 0;
+    while ((accumulator >= step) && (steps < maxSteps))
+    {
+        accumulator -= step;
+        steps++;
+    }
+    // Too far behind to catch up, drop the backlog instead of spiralling.
+    if (accumulator >= step)
+    {
+        accumulator = fmodf(accumulator, step);
+    }
+    return steps;
+}
+
+float FixedTimestep::GetAlpha() const
+{
+    return accumulator/step;
+}
+
+float FixedTimestep::GetStep() const
+{
+    return step;
+}
+
+TransformInterpolator::TransformInterpolator() :
+    alpha(1.0f)
+{
+}
+
+// Reorder v so that entry i becomes the old entry order[i].
+template <typename T>
+static void Permute(std::vector<T>& v, const std::vector<size_t>& order)
+{
+    std::vector<T> permuted;
+    permuted.reserve(v.size());
+    for (size_t i: order)
+    {
+        permuted.push_back(v[i]);
+    }
+    v.swap(permuted);
+}
+
+void TransformInterpolator::Track(GameTransform* root)
+{
+    size_t first = transforms.size();
+    bool relinked = false;
+    // Depth first, so every parent is listed before its children.
+    std::vector<std::pair<GameTransform*, int>> stack = { { root, -1 } };
+    if (root->GetParent() && indices.count(root->GetParent()))
+    {
+        stack.back().second = (int)indices[root->GetParent()];
+    }
+    while (!stack.empty())
+    {
+        GameTransform* node = stack.back().first;
+        int parent = stack.back().second;
+        stack.pop_back();
+        auto found = indices.find(node);
+        if (found != indices.end())
+        {
+            // Tracked before without its parent, which is tracked now.
+            if (parents[found->second] != parent)
+            {
+                parents[found->second] = parent;
+                relinked = true;
+            }
+            // Still visit its children, some may have been added since.
+            for (GameTransform* child: node->GetChildren())
+            {
+                stack.push_back({ child, (int)found->second });
+            }
+            continue;
+        }
+
+        int index = (int)transforms.size();
+        indices[node] = index;
+        transforms.push_back(node);
+        parents.push_back(parent);
+        for (GameTransform* child: node->GetChildren())
+        {
+            stack.push_back({ child, index });
+        }
+    }
+
+    size_t count = transforms.size();
+    previousPositions.resize(count);
+    previousRotations.resize(count);
+    previousScales.resize(count);
+    currentPositions.resize(count);
+    currentRotations.resize(count);
+    currentScales.resize(count);
+    worldMatrices.resize(count, MatrixIdentity());
+
+    // No motion to blend yet, both states of the new transforms hold their current pose.
+    // Transforms tracked before keep their states.
+    for (size_t i = first; i < count; i++)
+    {
+        currentPositions[i] = previousPositions[i] = transforms[i]->GetLocalPosition();
+        currentRotations[i] = previousRotations[i] = transforms[i]->GetLocalQuaternion();
+        currentScales[i] = previousScales[i] = transforms[i]->GetLocalScale();
+    }
+
+    if (relinked)
+    {
+        // Relinked subtrees now sit before their new parents, and their world matrices
+        // depend on them.
+        SortParentsFirst();
+        InterpolateRange(alpha, 0, count);
+    }
+    else
+    {
+        InterpolateRange(alpha, first, count);
+    }
+}
+
+bool TransformInterpolator::Untrack(const GameTransform* transform)
+{
+    auto found = indices.find(transform);
+    if (found == indices.end()) return false;
+
+    // Erase in place, a swap would move the last transform before its parent.
+    int index = (int)found->second;
+    indices.erase(found);
+    transforms.erase(transforms.begin() + index);
+    parents.erase(parents.begin() + index);
+    previousPositions.erase(previousPositions.begin() + index);
+    previousRotations.erase(previousRotations.begin() + index);
+    previousScales.erase(previousScales.begin() + index);
+    currentPositions.erase(currentPositions.begin() + index);
+    currentRotations.erase(currentRotations.begin() + index);
+    currentScales.erase(currentScales.begin() + index);
+    worldMatrices.erase(worldMatrices.begin() + index);
+
+    for (size_t i = index; i < transforms.size(); i++)
+    {
+        indices[transforms[i]] = i;
+    }
+    for (int& parent: parents)
+    {
+        // Children of the untracked transform fall back to its live world matrix.
+        if (parent == index) parent = -1;
+        else if (parent > index) parent--;
+    }
+    return true;
+}
+
+void TransformInterpolator::Clear()
+{
+    transforms.clear();
+    parents.clear();
+    indices.clear();
+    previousPositions.clear();
+    previousRotations.clear();
+    previousScales.clear();
+    currentPositions.clear();
+    currentRotations.clear();
+    currentScales.clear();
+    worldMatrices.clear();
+}
+
+size_t TransformInterpolator::GetCount() const
+{
+    return transforms.size();
+}
+
+void TransformInterpolator::Capture()
+{
+    previousPositions.swap(currentPositions);
+    previousRotations.swap(currentRotations);
+    previousScales.swap(currentScales);
+
+    for (size_t i = 0; i < transforms.size(); i++)
+    {
+        currentPositions[i] = transforms[i]->GetLocalPosition();
+        currentRotations[i] = transforms[i]->GetLocalQuaternion();
+        currentScales[i] = transforms[i]->GetLocalScale();
+    }
+}
+
+void TransformInterpolator::Interpolate(float alpha)
+{
+    this->alpha = alpha;
+    InterpolateRange(alpha, 0, transforms.size());
+}
+
+void TransformInterpolator::InterpolateRange(float alpha, size_t first, size_t last)
+{
+    for (size_t i = first; i < last; i++)
+    {
+        Vector3 position = Vector3Lerp(previousPositions[i], currentPositions[i], alpha);
+        Vector3 scale = Vector3Lerp(previousScales[i], currentScales[i], alpha);
+
+        // Nlerp along the shortest arc.
+        Quaternion from = previousRotations[i];
+        Quaternion to = currentRotations[i];
+        float dot = from.x*to.x + from.y*to.y + from.z*to.z + from.w*to.w;
+        if (dot < 0.0f) to = QuaternionScale(to, -1.0f);
+        Quaternion rotation = QuaternionNormalize(QuaternionLerp(from, to, alpha));
+
+        Matrix localMatrix = GameTransform::ComposeMatrix(position, rotation, scale);
+        if (parents[i] >= 0)
+        {
+            worldMatrices[i] = MatrixMultiply(localMatrix, worldMatrices[parents[i]]);
+        }
+        else if (transforms[i]->GetParent())
+        {
+            // Untracked parent, use its latest world matrix.
+            worldMatrices[i] = MatrixMultiply(localMatrix, transforms[i]->GetParent()->GetLocalToWorldMatrix());
+        }
+        else
+        {
+            worldMatrices[i] = localMatrix;
+        }
+    }
+}
+
+void TransformInterpolator::SortParentsFirst()
+{
+    // A parent is always closer to the root than its children.
+    std::vector<int> depths(transforms.size(), 0);
+    for (size_t i = 0; i < transforms.size(); i++)
+    {
+        for (const GameTransform* node = transforms[i]->GetParent(); node; node = node->GetParent())
+        {
+            depths[i]++;
+        }
+    }
+    std::vector<size_t> order(transforms.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return depths[a] < depths[b]; });
+
+    std::vector<int> newIndices(order.size());
+    for (size_t i = 0; i < order.size(); i++)
+    {
+        newIndices[order[i]] = (int)i;
+    }
+    for (int& parent: parents)
+    {
+        if (parent >= 0) parent = newIndices[parent];
+    }
+
+    Permute(transforms, order);
+    Permute(parents, order);
+    Permute(previousPositions, order);
+    Permute(previousRotations, order);
+    Permute(previousScales, order);
+    Permute(currentPositions, order);
+    Permute(currentRotations, order);
+    Permute(currentScales, order);
+    Permute(worldMatrices, order);
+    for (size_t i = 0; i < transforms.size(); i++)
+    {
+        indices[transforms[i]] = i;
+    }
+}
+
+Matrix TransformInterpolator::GetWorldMatrix(const GameTransform* transform) const
+{
+    auto found = indices.find(transform);
+    if (found == indices.end())
+    {
+        return transform->GetLocalToWorldMatrix();
+    }
+    return worldMatrices[found->second];
+}
+
+const std::vector<Matrix>& TransformInterpolator::GetWorldMatrices() const
+{
+    return worldMatrices;
+}
+
+}
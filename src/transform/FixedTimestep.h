@@ -0,0 +1,107 @@
+/*******************************************************************************************
+*
+*   FixedTimestep.h
+*   Definition of a FixedTimestep scheduler and a TransformInterpolator. Simulation writes
+*   GameTransforms at a fixed rate; the interpolator keeps the local position, rotation and
+*   scale of the last two simulation steps and blends them into world matrices for each
+*   rendered frame, so rendering can run faster than the simulation without stutter.
+*   Tracked transforms must be untracked before they are destroyed.
+*
+*   Partially inspired by https://gafferongames.com/post/fix_your_timestep/
+*
+*   LICENSE: GPLv3
+*
+*   Copyright (c) 2021 Juniper Dusk (@juniper-dusk)
+*
+*******************************************************************************************/
+
+#ifndef FIXEDTIMESTEP_H
+#define FIXEDTIMESTEP_H
+
+#include "raylib.h"
+#include "GameTransform.h"
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
+
+namespace GameEngine
+{
+
+class FixedTimestep
+{
+public:
+    // INITIALIZATION.
+    // Step length in seconds. At most maxSteps are run per frame, leftover time is dropped.
+    FixedTimestep(float step, int maxSteps = 8);
+
+    // Add a frame's elapsed time. Returns how many simulation steps to run now.
+    int Advance(float frameTime);
+    // How far the current frame lies between the last two steps, in [0, 1).
+    float GetAlpha() const;
+    float GetStep() const;
+
+protected:
+    float step;
+    int maxSteps;
+    float accumulator;
+};
+
+class TransformInterpolator
+{
+public:
+    // INITIALIZATION.
+    TransformInterpolator();
+    // Disallow copies.
+    TransformInterpolator(const TransformInterpolator& copy) = delete;
+
+    // TRACKING.
+    // Track a transform and all of its descendants. Both states of the new transforms start
+    // at their current pose; transforms tracked before keep their states, and are relinked
+    // if they were tracked without the new ancestors.
+    void Track(GameTransform* root);
+    // Stop tracking a single transform. Its tracked children follow its live world matrix.
+    // Returns false if it was not tracked.
+    bool Untrack(const GameTransform* transform);
+    void Clear();
+    size_t GetCount() const;
+
+    // SIMULATION.
+    // Record the local pose after a simulation step. The previous state is swapped out,
+    // not copied.
+    void Capture();
+
+    // RENDERING.
+    // Blend the last two steps and build every world matrix, parents before children.
+    void Interpolate(float alpha);
+    // Interpolated world matrix of a tracked transform, or its current one if untracked.
+    Matrix GetWorldMatrix(const GameTransform* transform) const;
+    const std::vector<Matrix>& GetWorldMatrices() const;
+
+protected:
+    // Tracked transforms with every parent before its children, and the index of each
+    // parent or -1.
+    std::vector<GameTransform*> transforms;
+    std::vector<int> parents;
+    std::unordered_map<const GameTransform*, size_t> indices;
+
+    // Local pose of the previous and current simulation step.
+    std::vector<Vector3> previousPositions;
+    std::vector<Quaternion> previousRotations;
+    std::vector<Vector3> previousScales;
+    std::vector<Vector3> currentPositions;
+    std::vector<Quaternion> currentRotations;
+    std::vector<Vector3> currentScales;
+
+    std::vector<Matrix> worldMatrices;
+    // Alpha of the last Interpolate(), newly tracked transforms are built with it.
+    float alpha;
+
+    // Interpolate tracked transforms [first, last). Parents outside it must be done already.
+    void InterpolateRange(float alpha, size_t first, size_t last);
+    // Restore the parents before children order after subtrees were relinked.
+    void SortParentsFirst();
+};
+
+}
+
+#endif // FIXEDTIMESTEP_H
@@ -15,6 +15,7 @@
 
 #include "GameTransform.h"
 #include "raymath.h"
+#include <algorithm>
 #include <iostream>
 #include <stdexcept>
 
@@ -47,7 +48,12 @@ Matrix QuatToMat(Quaternion q)
 
 const float EPSILON = 0.001;
 
-GameTransform::GameTransform()
+GameTransform::GameTransform() :
+    parent(nullptr),
+    localToWorld(MatrixIdentity()),
+    worldDirty(true),
+    worldVersion(0),
+    isStatic(false)
 {
     // Zero out data, exists at (0, 0, 0) world space.
     const Vector3 origin = {0, 0, 0};
@@ -61,7 +67,12 @@ GameTransform::GameTransform()
 GameTransform::GameTransform(
     Vector3 localPosition,
     RotationAxisAngle localRotation,
-    Vector3 localScale)
+    Vector3 localScale) :
+    parent(nullptr),
+    localToWorld(MatrixIdentity()),
+    worldDirty(true),
+    worldVersion(0),
+    isStatic(false)
 {
     SetLocalPosition(localPosition);
     SetLocalRotation(localRotation);
@@ -73,9 +84,10 @@ GameTransform::GameTransform(
 GameTransform::~GameTransform()
 {
     // Remove dangling pointers from children and parent.
-    for (GameTransform* child: children)
+    // SetParent removes the child from our list, so always detach the front.
+    while (!children.empty())
     {
-        child->SetParent(nullptr);
+        children.front()->SetParent(nullptr);
     }
     if (parent)
     {
@@ -91,6 +103,7 @@ Vector3 GameTransform::GetLocalPosition() const
 void GameTransform::SetLocalPosition(Vector3 localPosition)
 {
     position = localPosition;
+    MarkWorldDirty();
 }
 
 Vector3 GameTransform::GetWorldPosition() const
@@ -112,6 +125,7 @@ RotationAxisAngle GameTransform::GetLocalRotation() const
 void GameTransform::SetLocalRotation(RotationAxisAngle rotation)
 {
     this->rotation = QuaternionFromAxisAngle(rotation.axis, rotation.angle * DEG2RAD);
+    MarkWorldDirty();
 }
 
 RotationAxisAngle GameTransform::GetWorldRotation() const
@@ -141,6 +155,17 @@ RotationAxisAngle GameTransform::GetWorldRotation() const
     return { rotationAxis, rotationAngle * RAD2DEG };
 }
 
+Quaternion GameTransform::GetLocalQuaternion() const
+{
+    return rotation;
+}
+
+void GameTransform::SetLocalQuaternion(Quaternion rotation)
+{
+    this->rotation = rotation;
+    MarkWorldDirty();
+}
+
 Vector3 GameTransform::GetLocalScale() const
 {
     return scale;
@@ -149,6 +174,7 @@ Vector3 GameTransform::GetLocalScale() const
 void GameTransform::SetLocalScale(Vector3 localScale)
 {
     scale = localScale;
+    MarkWorldDirty();
 }
 
 Vector3 GameTransform::GetWorldScale() const
@@ -159,21 +185,41 @@ Vector3 GameTransform::GetWorldScale() const
     return ExtractScale(ltwMat);
 }
 
+void GameTransform::SetLocalPose(Vector3 localPosition, Quaternion localRotation, Vector3 localScale)
+{
+    position = localPosition;
+    rotation = localRotation;
+    scale = localScale;
+    MarkWorldDirty();
+}
+
 Matrix GameTransform::GetLocalToWorldMatrix() const
 {
+    if (!worldDirty)
+    {
+        return localToWorld;
+    }
     if (parent)
     {
         // Get parent matrix.
         Matrix parentMatrix = parent->GetLocalToWorldMatrix();
         Matrix childMatrix = MakeLocalToParent();
         // Multiply matrices.
-        return MatrixMultiply(childMatrix, parentMatrix);
+        localToWorld = MatrixMultiply(childMatrix, parentMatrix);
     }
     else
     {
         // Base case: root node.
-        return MakeLocalToParent();
+        localToWorld = MakeLocalToParent();
     }
+    worldDirty = false;
+    worldVersion++;
+    return localToWorld;
+}
+
+Matrix GameTransform::GetLocalMatrix() const
+{
+    return MakeLocalToParent();
 }
 
 Matrix GameTransform::GetWorldToLocalMatrix() const
@@ -181,15 +227,16 @@ Matrix GameTransform::GetWorldToLocalMatrix() const
     return MatrixInvert(GetLocalToWorldMatrix());
 }
 
-Matrix GameTransform::MakeLocalToParent() const
+unsigned int GameTransform::GetWorldVersion() const
 {
-    // Get matrices for transformation from local to parent.
-    Matrix scaleMatrix = MatrixScale(scale.x, scale.y, scale.z);
-    Matrix rotationMatrix = QuaternionToMatrix(QuaternionNormalize(rotation));
-    Matrix translationMatrix = MatrixTranslate(position.x, position.y, position.z);
+    // Make sure the version reflects any pending change.
+    GetLocalToWorldMatrix();
+    return worldVersion;
+}
 
-    // Order matters: scale -> rotation -> translation.
-    return MatrixMultiply(MatrixMultiply(scaleMatrix, rotationMatrix), translationMatrix);
+Matrix GameTransform::MakeLocalToParent() const
+{
+    return ComposeMatrix(position, rotation, scale);
 }
 
 Matrix GameTransform::MakeParentToLocal() const
@@ -197,6 +244,37 @@ Matrix GameTransform::MakeParentToLocal() const
     return MatrixInvert(MakeLocalToParent());
 }
 
+Matrix GameTransform::ComposeMatrix(Vector3 position, Quaternion rotation, Vector3 scale)
+{
+    // Order matters: scale -> rotation -> translation.
+    // Written out instead of multiplying three matrices: scaling the rows of the rotation
+    // and filling in the translation gives the same result.
+    Matrix result = QuaternionToMatrix(QuaternionNormalize(rotation));
+    result.m0 *= scale.x; result.m1 *= scale.x; result.m2 *= scale.x;
+    result.m4 *= scale.y; result.m5 *= scale.y; result.m6 *= scale.y;
+    result.m8 *= scale.z; result.m9 *= scale.z; result.m10 *= scale.z;
+    result.m12 = position.x;
+    result.m13 = position.y;
+    result.m14 = position.z;
+    return result;
+}
+
+Quaternion GameTransform::LookRotation(Vector3 forward, Vector3 up)
+{
+    // Orthonormal basis with z along forward and x perpendicular to up.
+    Vector3 z = Vector3Normalize(forward);
+    Vector3 x = Vector3CrossProduct(up, z);
+    // Up along forward, any side axis will do.
+    if (Vector3Length(x) < 0.000001f) x = Vector3Perpendicular(z);
+    x = Vector3Normalize(x);
+    Vector3 y = Vector3CrossProduct(z, x);
+    Matrix basis = MatrixIdentity();
+    basis.m0 = x.x; basis.m1 = x.y; basis.m2 = x.z;
+    basis.m4 = y.x; basis.m5 = y.y; basis.m6 = y.z;
+    basis.m8 = z.x; basis.m9 = z.y; basis.m10 = z.z;
+    return QuaternionFromMatrix(basis);
+}
+
 Vector3 GameTransform::ExtractTranslation(Matrix transform)
 {
     float position_x = transform.m12;
@@ -230,6 +308,30 @@ Vector3 GameTransform::ExtractScale(Matrix transform)
     };
 }
 
+bool GameTransform::IsStatic() const
+{
+    return isStatic;
+}
+
+void GameTransform::SetStatic(bool isStatic)
+{
+    this->isStatic = isStatic;
+}
+
+void GameTransform::MarkWorldDirty()
+{
+    // A dirty node always has dirty descendants, so the walk can stop early.
+    if (worldDirty)
+    {
+        return;
+    }
+    worldDirty = true;
+    for (GameTransform* child: children)
+    {
+        child->MarkWorldDirty();
+    }
+}
+
 void GameTransform::SetParent(GameTransform* newParent, unsigned int childIndex)
 {
     if (parent)
@@ -242,10 +344,21 @@ void GameTransform::SetParent(GameTransform* newParent, unsigned int childIndex)
     if (parent)
     {
         // Insert pointer to current node at given index in parent's children.
-        auto iterator = children.begin();
-        std::advance(iterator, childIndex);
+        auto iterator = parent->children.begin();
+        std::advance(iterator, std::min<size_t>(childIndex, parent->children.size()));
         parent->children.insert(iterator, this);
     }
+    MarkWorldDirty();
+}
+
+GameTransform* GameTransform::GetParent() const
+{
+    return parent;
+}
+
+const std::list<GameTransform*>& GameTransform::GetChildren() const
+{
+    return children;
 }
 
 }
\ No newline at end of file
@@ -13,6 +13,9 @@
 *
 *******************************************************************************************/
 
+#ifndef GAMETRANSFORM_H
+#define GAMETRANSFORM_H
+
 #include "raylib.h"
 #include <list>
 #include <memory>
@@ -54,6 +57,9 @@ public:
     void SetLocalRotation(RotationAxisAngle rotation);
     // World.
     RotationAxisAngle GetWorldRotation() const;
+    // Local, as a quaternion. Skips the axis-angle conversion for batch systems.
+    Quaternion GetLocalQuaternion() const;
+    void SetLocalQuaternion(Quaternion rotation);
 
     // SCALE PROPERTY.
     // Local.
@@ -62,18 +68,37 @@ public:
     // World.
     Vector3 GetWorldScale() const;
 
+    // POSE.
+    // Set local position, rotation and scale at once, marking the subtree dirty once.
+    void SetLocalPose(Vector3 localPosition, Quaternion localRotation, Vector3 localScale);
+
     // SPACE TRANSFORMATIONS.
+    // Local to parent space.
+    Matrix GetLocalMatrix() const;
     // Local to world space.
     Matrix GetLocalToWorldMatrix() const;
     // World to local space.
     Matrix GetWorldToLocalMatrix() const;
+    // Changes every time the cached local to world matrix is rebuilt.
+    unsigned int GetWorldVersion() const;
 
+    // Scale -> rotation -> translation matrix, as used for local to parent.
+    static Matrix ComposeMatrix(Vector3 position, Quaternion rotation, Vector3 scale);
     static Vector3 ExtractTranslation(Matrix transform);
     static Matrix  ExtractRotation(Matrix transform);
     static Vector3 ExtractScale(Matrix transform);
+    // Rotation taking +Z along forward, with +Y as close to up as it allows.
+    static Quaternion LookRotation(Vector3 forward, Vector3 up);
+
+    // STATIC PROPERTY.
+    // Static transforms promise not to move, so what hangs under them can be baked.
+    bool IsStatic() const;
+    void SetStatic(bool isStatic);
 
     // HIERARCHY OPERATIONS.
     void SetParent(GameTransform* newParent, unsigned int childIndex = 0);
+    GameTransform* GetParent() const;
+    const std::list<GameTransform*>& GetChildren() const;
 
 protected:
     // Parent transform.
@@ -90,9 +115,21 @@ protected:
     // Used as rotation axis.
     Vector3 origin;
 
+    // Cached local to world matrix, rebuilt on demand after a change.
+    mutable Matrix localToWorld;
+    mutable bool worldDirty;
+    mutable unsigned int worldVersion;
+
+    // Set on transforms that never move after setup.
+    bool isStatic;
+
     // Matrices.
     Matrix MakeLocalToParent() const;
     Matrix MakeParentToLocal() const;
+    // Flag this transform and its descendants for a world matrix rebuild.
+    void MarkWorldDirty();
 };
 
-}
\ No newline at end of file
+}
+
+#endif // GAMETRANSFORM_H
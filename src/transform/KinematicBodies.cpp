@@ -0,0 +1,378 @@
+/*******************************************************************************************
+*
+*   KinematicBodies.cpp
+*   Implementation of KinematicBodies.
+*
+*   LICENSE: GPLv3
+*
+*   Copyright (c) 2021 Juniper Dusk (@juniper-dusk)
+*
+*******************************************************************************************/
+
+#include "KinematicBodies.h"
+#include "raymath.h"
+#include <algorithm>
+#include <cmath>
+
+// SSE2 is part of every x86-64 CPU, so no runtime check is needed.
+#if defined(__SSE2__) || defined(_M_X64)
+    #define KINEMATICS_SSE
+    #include <emmintrin.h>
+#endif
+
+namespace GameEngine
+{
+
+KinematicBodies::KinematicBodies(float restSpeed) :
+    restSpeed(restSpeed),
+    keepStep(0.0f)
+{
+}
+
+int KinematicBodies::Add(GameTransform* transform)
+{
+    KinematicBody body = { transform, -1, { 0.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 0.0f }, 0.0f, 0.0f };
+    if (!freeIds.empty())
+    {
+        int id = freeIds.back();
+        freeIds.pop_back();
+        bodies[id] = body;
+        return id;
+    }
+    bodies.push_back(body);
+    return (int)bodies.size() - 1;
+}
+
+void KinematicBodies::Remove(int id)
+{
+    if ((id < 0) || (id >= (int)bodies.size()) || !bodies[id].transform) return;
+    Sleep(id);
+    bodies[id].transform = nullptr;
+    freeIds.push_back(id);
+}
+
+void KinematicBodies::Clear()
+{
+    bodies.clear();
+    freeIds.clear();
+    ids.clear();
+    for (int c = 0; c < 3; c++)
+    {
+        position[c].clear();
+        linear[c].clear();
+        angular[c].clear();
+    }
+    for (int c = 0; c < 4; c++)
+    {
+        rotation[c].clear();
+    }
+    linearKeep.clear();
+    angularKeep.clear();
+}
+
+int KinematicBodies::GetCount() const
+{
+    return (int)(bodies.size() - freeIds.size());
+}
+
+int KinematicBodies::GetMovingCount() const
+{
+    return (int)ids.size();
+}
+
+bool KinematicBodies::IsAtRest(int id) const
+{
+    return bodies.at(id).slot < 0;
+}
+
+void KinematicBodies::Refresh(int id)
+{
+    int slot = bodies.at(id).slot;
+    if (slot < 0) return;
+    Vector3 localPosition = bodies[id].transform->GetLocalPosition();
+    Quaternion localRotation = QuaternionNormalize(bodies[id].transform->GetLocalQuaternion());
+    position[0][slot] = localPosition.x;
+    position[1][slot] = localPosition.y;
+    position[2][slot] = localPosition.z;
+    rotation[0][slot] = localRotation.x;
+    rotation[1][slot] = localRotation.y;
+    rotation[2][slot] = localRotation.z;
+    rotation[3][slot] = localRotation.w;
+}
+
+Vector3 KinematicBodies::GetLinearVelocity(int id) const
+{
+    int slot = bodies.at(id).slot;
+    if (slot < 0) return bodies[id].linearVelocity;
+    return { linear[0][slot], linear[1][slot], linear[2][slot] };
+}
+
+void KinematicBodies::SetLinearVelocity(int id, Vector3 velocity)
+{
+    if (bodies.at(id).slot >= 0) Store(id);
+    bodies[id].linearVelocity = velocity;
+    Wake(id);
+}
+
+Vector3 KinematicBodies::GetAngularVelocity(int id) const
+{
+    int slot = bodies.at(id).slot;
+    if (slot < 0) return bodies[id].angularVelocity;
+    return { angular[0][slot], angular[1][slot], angular[2][slot] };
+}
+
+void KinematicBodies::SetAngularVelocity(int id, Vector3 velocity)
+{
+    if (bodies.at(id).slot >= 0) Store(id);
+    bodies[id].angularVelocity = velocity;
+    Wake(id);
+}
+
+void KinematicBodies::SetDamping(int id, float linear, float angular)
+{
+    KinematicBody& body = bodies.at(id);
+    body.linearDamping = std::max(0.0f, linear);
+    body.angularDamping = std::max(0.0f, angular);
+    if (body.slot >= 0) UpdateKeep(body.slot);
+}
+
+void KinematicBodies::Integrate(float deltaTime)
+{
+    int count = (int)ids.size();
+    if (deltaTime != keepStep)
+    {
+        keepStep = deltaTime;
+        for (int slot = 0; slot < count; slot++)
+        {
+            UpdateKeep(slot);
+        }
+    }
+    resting.clear();
+    IntegrateRange(0, count, deltaTime);
+
+    // Write back only what moves: a spinning pickup never touches its position.
+    for (int slot = 0; slot < count; slot++)
+    {
+        GameTransform* transform = bodies[ids[slot]].transform;
+        if ((linear[0][slot] != 0.0f) || (linear[1][slot] != 0.0f) || (linear[2][slot] != 0.0f))
+        {
+            transform->SetLocalPosition({ position[0][slot], position[1][slot], position[2][slot] });
+        }
+        if ((angular[0][slot] != 0.0f) || (angular[1][slot] != 0.0f) || (angular[2][slot] != 0.0f))
+        {
+            transform->SetLocalQuaternion({ rotation[0][slot], rotation[1][slot], rotation[2][slot], rotation[3][slot] });
+        }
+    }
+
+    // Back to front, so a body moved into a freed slot is never one still to be removed.
+    for (int i = (int)resting.size() - 1; i >= 0; i--)
+    {
+        int id = ids[resting[i]];
+        Store(id);
+        bodies[id].linearVelocity = { 0.0f, 0.0f, 0.0f };
+        bodies[id].angularVelocity = { 0.0f, 0.0f, 0.0f };
+        Sleep(id);
+    }
+}
+
+void KinematicBodies::Wake(int id)
+{
+    KinematicBody& body = bodies[id];
+    float speed = std::max(Vector3Length(body.linearVelocity), Vector3Length(body.angularVelocity));
+    if (speed < restSpeed)
+    {
+        Sleep(id);
+        return;
+    }
+    if (body.slot < 0)
+    {
+        body.slot = (int)ids.size();
+        ids.push_back(id);
+        for (int c = 0; c < 3; c++)
+        {
+            position[c].push_back(0.0f);
+            linear[c].push_back(0.0f);
+            angular[c].push_back(0.0f);
+        }
+        for (int c = 0; c < 4; c++)
+        {
+            rotation[c].push_back(0.0f);
+        }
+        linearKeep.push_back(1.0f);
+        angularKeep.push_back(1.0f);
+        Refresh(id);
+    }
+
+    int slot = body.slot;
+    linear[0][slot] = body.linearVelocity.x;
+    linear[1][slot] = body.linearVelocity.y;
+    linear[2][slot] = body.linearVelocity.z;
+    angular[0][slot] = body.angularVelocity.x;
+    angular[1][slot] = body.angularVelocity.y;
+    angular[2][slot] = body.angularVelocity.z;
+    UpdateKeep(slot);
+}
+
+void KinematicBodies::Sleep(int id)
+{
+    int slot = bodies[id].slot;
+    if (slot < 0) return;
+
+    // Swap the last moving body into the freed slot.
+    int last = (int)ids.size() - 1;
+    if (slot != last)
+    {
+        ids[slot] = ids[last];
+        for (int c = 0; c < 3; c++)
+        {
+            position[c][slot] = position[c][last];
+            linear[c][slot] = linear[c][last];
+            angular[c][slot] = angular[c][last];
+        }
+        for (int c = 0; c < 4; c++)
+        {
+            rotation[c][slot] = rotation[c][last];
+        }
+        linearKeep[slot] = linearKeep[last];
+        angularKeep[slot] = angularKeep[last];
+        bodies[ids[slot]].slot = slot;
+    }
+    ids.pop_back();
+    for (int c = 0; c < 3; c++)
+    {
+        position[c].pop_back();
+        linear[c].pop_back();
+        angular[c].pop_back();
+    }
+    for (int c = 0; c < 4; c++)
+    {
+        rotation[c].pop_back();
+    }
+    linearKeep.pop_back();
+    angularKeep.pop_back();
+    bodies[id].slot = -1;
+}
+
+void KinematicBodies::Store(int id)
+{
+    int slot = bodies[id].slot;
+    bodies[id].linearVelocity = { linear[0][slot], linear[1][slot], linear[2][slot] };
+    bodies[id].angularVelocity = { angular[0][slot], angular[1][slot], angular[2][slot] };
+}
+
+void KinematicBodies::UpdateKeep(int slot)
+{
+    const KinematicBody& body = bodies[ids[slot]];
+    linearKeep[slot] = expf(-body.linearDamping*keepStep);
+    angularKeep[slot] = expf(-body.angularDamping*keepStep);
+}
+
+void KinematicBodies::IntegrateRange(int first, int last, float deltaTime)
+{
+    float* px = position[0].data();
+    float* py = position[1].data();
+    float* pz = position[2].data();
+    float* qx = rotation[0].data();
+    float* qy = rotation[1].data();
+    float* qz = rotation[2].data();
+    float* qw = rotation[3].data();
+    float* vx = linear[0].data();
+    float* vy = linear[1].data();
+    float* vz = linear[2].data();
+    float* wx = angular[0].data();
+    float* wy = angular[1].data();
+    float* wz = angular[2].data();
+    const float* kv = linearKeep.data();
+    const float* kw = angularKeep.data();
+    float restSquared = restSpeed*restSpeed;
+    int i = first;
+
+#ifdef KINEMATICS_SSE
+    const __m128 dt = _mm_set1_ps(deltaTime);
+    const __m128 halfDt = _mm_set1_ps(0.5f*deltaTime);
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 rest = _mm_set1_ps(restSquared);
+    for (; i + 4 <= last; i += 4)
+    {
+        // Damp first, velocities keep exp(-damping*dt) of themselves.
+        __m128 keepLinear = _mm_loadu_ps(kv + i);
+        __m128 keepAngular = _mm_loadu_ps(kw + i);
+        __m128 lx = _mm_mul_ps(_mm_loadu_ps(vx + i), keepLinear);
+        __m128 ly = _mm_mul_ps(_mm_loadu_ps(vy + i), keepLinear);
+        __m128 lz = _mm_mul_ps(_mm_loadu_ps(vz + i), keepLinear);
+        __m128 ax = _mm_mul_ps(_mm_loadu_ps(wx + i), keepAngular);
+        __m128 ay = _mm_mul_ps(_mm_loadu_ps(wy + i), keepAngular);
+        __m128 az = _mm_mul_ps(_mm_loadu_ps(wz + i), keepAngular);
+        _mm_storeu_ps(vx + i, lx);
+        _mm_storeu_ps(vy + i, ly);
+        _mm_storeu_ps(vz + i, lz);
+        _mm_storeu_ps(wx + i, ax);
+        _mm_storeu_ps(wy + i, ay);
+        _mm_storeu_ps(wz + i, az);
+
+        _mm_storeu_ps(px + i, _mm_add_ps(_mm_loadu_ps(px + i), _mm_mul_ps(lx, dt)));
+        _mm_storeu_ps(py + i, _mm_add_ps(_mm_loadu_ps(py + i), _mm_mul_ps(ly, dt)));
+        _mm_storeu_ps(pz + i, _mm_add_ps(_mm_loadu_ps(pz + i), _mm_mul_ps(lz, dt)));
+
+        // q += dt/2 * (w, 0) * q, then normalize.
+        __m128 x = _mm_loadu_ps(qx + i);
+        __m128 y = _mm_loadu_ps(qy + i);
+        __m128 z = _mm_loadu_ps(qz + i);
+        __m128 w = _mm_loadu_ps(qw + i);
+        __m128 dx = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(ax, w), _mm_mul_ps(ay, z)), _mm_mul_ps(az, y));
+        __m128 dy = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(ay, w), _mm_mul_ps(az, x)), _mm_mul_ps(ax, z));
+        __m128 dz = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(az, w), _mm_mul_ps(ax, y)), _mm_mul_ps(ay, x));
+        __m128 dw = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax, x), _mm_mul_ps(ay, y)), _mm_mul_ps(az, z));
+        x = _mm_add_ps(x, _mm_mul_ps(dx, halfDt));
+        y = _mm_add_ps(y, _mm_mul_ps(dy, halfDt));
+        z = _mm_add_ps(z, _mm_mul_ps(dz, halfDt));
+        w = _mm_sub_ps(w, _mm_mul_ps(dw, halfDt));
+        __m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)),
+            _mm_add_ps(_mm_mul_ps(z, z), _mm_mul_ps(w, w))));
+        __m128 scale = _mm_div_ps(one, length);
+        _mm_storeu_ps(qx + i, _mm_mul_ps(x, scale));
+        _mm_storeu_ps(qy + i, _mm_mul_ps(y, scale));
+        _mm_storeu_ps(qz + i, _mm_mul_ps(z, scale));
+        _mm_storeu_ps(qw + i, _mm_mul_ps(w, scale));
+
+        __m128 linearSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(lx, lx), _mm_mul_ps(ly, ly)), _mm_mul_ps(lz, lz));
+        __m128 angularSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax, ax), _mm_mul_ps(ay, ay)), _mm_mul_ps(az, az));
+        int stopped = _mm_movemask_ps(_mm_and_ps(_mm_cmplt_ps(linearSquared, rest), _mm_cmplt_ps(angularSquared, rest)));
+        for (int lane = 0; stopped; lane++, stopped >>= 1)
+        {
+            if (stopped & 1) resting.push_back(i + lane);
+        }
+    }
+#endif
+
+    const float halfStep = 0.5f*deltaTime;
+    for (; i < last; i++)
+    {
+        vx[i] *= kv[i];
+        vy[i] *= kv[i];
+        vz[i] *= kv[i];
+        wx[i] *= kw[i];
+        wy[i] *= kw[i];
+        wz[i] *= kw[i];
+
+        px[i] += vx[i]*deltaTime;
+        py[i] += vy[i]*deltaTime;
+        pz[i] += vz[i]*deltaTime;
+
+        float x = qx[i] + (wx[i]*qw[i] + wy[i]*qz[i] - wz[i]*qy[i])*halfStep;
+        float y = qy[i] + (wy[i]*qw[i] + wz[i]*qx[i] - wx[i]*qz[i])*halfStep;
+        float z = qz[i] + (wz[i]*qw[i] + wx[i]*qy[i] - wy[i]*qx[i])*halfStep;
+        float w = qw[i] - (wx[i]*qx[i] + wy[i]*qy[i] + wz[i]*qz[i])*halfStep;
+        float scale = 1.0f/sqrtf(x*x + y*y + z*z + w*w);
+        qx[i] = x*scale;
+        qy[i] = y*scale;
+        qz[i] = z*scale;
+        qw[i] = w*scale;
+
+        float linearSquared = vx[i]*vx[i] + vy[i]*vy[i] + vz[i]*vz[i];
+        float angularSquared = wx[i]*wx[i] + wy[i]*wy[i] + wz[i]*wz[i];
+        if ((linearSquared < restSquared) && (angularSquared < restSquared)) resting.push_back(i);
+    }
+}
+
+}
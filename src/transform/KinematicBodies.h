@@ -0,0 +1,107 @@
+/*******************************************************************************************
+*
+*   KinematicBodies.h
+*   Definition of KinematicBodies. Transforms moved by a linear and an angular velocity,
+*   such as spinning pickups, fans and drifting debris. Moving bodies keep their local
+*   position, rotation and velocities in flat arrays, integrated four bodies at a time with
+*   SSE, and the results are written to the transforms. Bodies whose velocities damp out
+*   fall out of the arrays and cost nothing until they are given a velocity again.
+*
+*   While a body moves its local position and rotation are driven from the arrays; call
+*   Refresh() after moving it by hand.
+*
+*   LICENSE: GPLv3
+*
+*   Copyright (c) 2021 Juniper Dusk (@juniper-dusk)
+*
+*******************************************************************************************/
+
+#ifndef KINEMATICBODIES_H
+#define KINEMATICBODIES_H
+
+#include "raylib.h"
+#include "GameTransform.h"
+#include <vector>
+
+namespace GameEngine
+{
+
+class KinematicBodies
+{
+public:
+    // INITIALIZATION.
+    // Bodies slower than restSpeed, in units and radians per second, come to rest.
+    KinematicBodies(float restSpeed = 0.0001f);
+    // Disallow copies.
+    KinematicBodies(const KinematicBodies& copy) = delete;
+
+    // BODIES.
+    // Returns the body's id. It starts at rest. Transforms must outlive their bodies.
+    int Add(GameTransform* transform);
+    void Remove(int id);
+    void Clear();
+    int GetCount() const;
+    // Bodies still moving.
+    int GetMovingCount() const;
+    bool IsAtRest(int id) const;
+    // Read the transform's local position and rotation again.
+    void Refresh(int id);
+
+    // VELOCITY PROPERTIES.
+    // In the parent's space, per second. Angular velocity is an axis scaled by radians.
+    Vector3 GetLinearVelocity(int id) const;
+    void SetLinearVelocity(int id, Vector3 velocity);
+    Vector3 GetAngularVelocity(int id) const;
+    void SetAngularVelocity(int id, Vector3 velocity);
+    // Exponential damping rate per second: each step keeps exp(-damping*dt) of the
+    // velocity, so the decay is the same at any frame rate. Undamped bodies never come to
+    // rest.
+    void SetDamping(int id, float linear, float angular);
+
+    // INTEGRATION.
+    // Advance every moving body and write its local position and rotation.
+    void Integrate(float deltaTime);
+
+protected:
+    typedef struct KinematicBody
+    {
+        // Null for a free id.
+        GameTransform* transform;
+        // Index in the moving arrays, -1 at rest.
+        int slot;
+        Vector3 linearVelocity;
+        Vector3 angularVelocity;
+        float linearDamping;
+        float angularDamping;
+    } KinematicBody;
+
+    float restSpeed;
+    std::vector<KinematicBody> bodies;
+    std::vector<int> freeIds;
+
+    // Moving bodies, one array per component.
+    std::vector<int> ids;
+    std::vector<float> position[3];
+    std::vector<float> rotation[4];
+    std::vector<float> linear[3];
+    std::vector<float> angular[3];
+    // Fraction of velocity each moving body keeps per step of keepStep seconds, so the
+    // exponentials are only evaluated when the step or a damping changes.
+    std::vector<float> linearKeep;
+    std::vector<float> angularKeep;
+    float keepStep;
+    // Slots that came to rest during the last integration.
+    std::vector<int> resting;
+
+    void Wake(int id);
+    void Sleep(int id);
+    // Copy a moving body's velocities back to its record.
+    void Store(int id);
+    // Compute a moving body's keep factors for keepStep.
+    void UpdateKeep(int slot);
+    void IntegrateRange(int first, int last, float deltaTime);
+};
+
+}
+
+#endif // KINEMATICBODIES_H
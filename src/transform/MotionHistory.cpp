@@ -0,0 +1,121 @@
+/*******************************************************************************************
+*
+*   MotionHistory.cpp
+*   Implementation of a MotionHistory.
+*
+*   LICENSE: GPLv3
+*
+*   Copyright (c) 2021 Juniper Dusk (@juniper-dusk)
+*
+*******************************************************************************************/
+
+#include "MotionHistory.h"
+
+namespace GameEngine
+{
+
+MotionHistory::MotionHistory()
+{
+}
+
+size_t MotionHistory::Track(const GameTransform* transform)
+{
+    auto found = indices.find(transform);
+    if (found != indices.end()) return found->second;
+
+    size_t index = transforms.size();
+    indices[transform] = index;
+    transforms.push_back(transform);
+    Matrix world = transform->GetLocalToWorldMatrix();
+    previousMatrices.push_back(world);
+    currentMatrices.push_back(world);
+    return index;
+}
+
+bool MotionHistory::Untrack(const GameTransform* transform)
+{
+    auto found = indices.find(transform);
+    if (found == indices.end()) return false;
+
+    size_t index = found->second;
+    size_t last = transforms.size() - 1;
+    indices.erase(found);
+    if (index != last)
+    {
+        transforms[index] = transforms[last];
+        previousMatrices[index] = previousMatrices[last];
+        currentMatrices[index] = currentMatrices[last];
+        indices[transforms[index]] = index;
+    }
+    transforms.pop_back();
+    previousMatrices.pop_back();
+    currentMatrices.pop_back();
+    return true;
+}
+
+void MotionHistory::Clear()
+{
+    transforms.clear();
+    indices.clear();
+    previousMatrices.clear();
+    currentMatrices.clear();
+}
+
+size_t MotionHistory::GetCount() const
+{
+    return transforms.size();
+}
+
+int MotionHistory::GetIndex(const GameTransform* transform) const
+{
+    auto found = indices.find(transform);
+    return (found != indices.end())? (int)found->second : -1;
+}
+
+void MotionHistory::BeginFrame()
+{
+    previousMatrices.swap(currentMatrices);
+}
+
+void MotionHistory::Capture()
+{
+    for (size_t i = 0; i < transforms.size(); i++)
+    {
+        currentMatrices[i] = transforms[i]->GetLocalToWorldMatrix();
+    }
+}
+
+const Matrix& MotionHistory::GetPrevious(size_t index) const
+{
+    return previousMatrices.at(index);
+}
+
+const Matrix& MotionHistory::GetCurrent(size_t index) const
+{
+    return currentMatrices.at(index);
+}
+
+Vector3 MotionHistory::GetLinearVelocity(size_t index, float frameTime) const
+{
+    const Matrix& previous = previousMatrices.at(index);
+    const Matrix& current = currentMatrices.at(index);
+    // Paused or zero length frames have no velocity.
+    if (frameTime <= 0.0f) return { 0.0f, 0.0f, 0.0f };
+    return {
+        (current.m12 - previous.m12)/frameTime,
+        (current.m13 - previous.m13)/frameTime,
+        (current.m14 - previous.m14)/frameTime
+    };
+}
+
+const std::vector<Matrix>& MotionHistory::GetPreviousMatrices() const
+{
+    return previousMatrices;
+}
+
+const std::vector<Matrix>& MotionHistory::GetCurrentMatrices() const
+{
+    return currentMatrices;
+}
+
+}
@@ -0,0 +1,74 @@
+/*******************************************************************************************
+*
+*   MotionHistory.h
+*   Definition of a MotionHistory. Keeps last frame's world matrix next to the current one
+*   for the transforms that opt in, for motion vectors, velocity and extrapolation. Both
+*   frames live in flat arrays; starting a frame swaps the arrays, so last frame's matrices
+*   are never copied, and reading a pair is two array loads.
+*
+*   Tracked transforms must be untracked before they are destroyed.
+*
+*   LICENSE: GPLv3
+*
+*   Copyright (c) 2021 Juniper Dusk (@juniper-dusk)
+*
+*******************************************************************************************/
+
+#ifndef MOTIONHISTORY_H
+#define MOTIONHISTORY_H
+
+#include "raylib.h"
+#include "GameTransform.h"
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
+
+namespace GameEngine
+{
+
+class MotionHistory
+{
+public:
+    // INITIALIZATION.
+    MotionHistory();
+    // Disallow copies.
+    MotionHistory(const MotionHistory& copy) = delete;
+
+    // TRACKING.
+    // Keep history for a transform. Returns its index in the matrix arrays. A new transform
+    // starts at rest, with both frames set to its current world matrix.
+    size_t Track(const GameTransform* transform);
+    // Stop keeping history for a transform. The last tracked transform moves into its
+    // index. Returns false if the transform was not tracked.
+    bool Untrack(const GameTransform* transform);
+    void Clear();
+    size_t GetCount() const;
+    // Index of a tracked transform, or -1.
+    int GetIndex(const GameTransform* transform) const;
+
+    // FRAMES.
+    // Start a frame: the current matrices become the previous ones.
+    void BeginFrame();
+    // Record the current world matrices, once the frame's transforms are final.
+    void Capture();
+
+    // QUERIES.
+    const Matrix& GetPrevious(size_t index) const;
+    const Matrix& GetCurrent(size_t index) const;
+    // World space distance moved since last frame, divided by frameTime. Zero when
+    // frameTime is not positive.
+    Vector3 GetLinearVelocity(size_t index, float frameTime) const;
+    // Matrices of every tracked transform, in tracking order.
+    const std::vector<Matrix>& GetPreviousMatrices() const;
+    const std::vector<Matrix>& GetCurrentMatrices() const;
+
+protected:
+    std::vector<const GameTransform*> transforms;
+    std::unordered_map<const GameTransform*, size_t> indices;
+    std::vector<Matrix> previousMatrices;
+    std::vector<Matrix> currentMatrices;
+};
+
+}
+
+#endif // MOTIONHISTORY_H